@@ -4,53 +4,648 @@
 #include <signal.h>       // For kill()
 #include <dirent.h>       // For reading /proc
 #include <pwd.h>          // For getpwuid()
+#include <fcntl.h>        // For open()
+#include <errno.h>        // For errno (permission checks)
+#include <sys/socket.h>   // For the taskstats netlink socket
+#include <sys/stat.h>     // For stat() on /proc/[pid]/task
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/taskstats.h>
+#include <time.h>         // For clock_gettime()
+#include <poll.h>         // For poll() on stdin and PSI triggers
+#include <clocale>        // For setlocale() (UTF-8 braille graphs)
+#include <langinfo.h>     // For nl_langinfo()
 #include <fstream>        // For reading files
 #include <sstream>        // For string parsing
 #include <string>         // For std::string
 #include <vector>         // For std::vector
 #include <map>            // For std::map (to store process times)
+#include <set>            // For std::set (collapsed cgroups)
+#include <unordered_map>  // For std::unordered_map (cgroup rates)
+#include <unordered_set>  // For the interfaces and disks present now
+#include <cstring>        // For strncmp(), strchr()
+#include <strings.h>      // For strcasecmp() (command line)
+#include <string_view>    // For allocation-free group keys
 #include <algorithm>      // For std::sort
 #include <iomanip>        // For std::setw, std::setprecision
 #include <cmath>          // For std::round
+#include <cstdint>        // For uint32_t (perfect hash)
+#include <thread>         // For the background /proc reader
+#include <mutex>
+#include <condition_variable>
+#include <deque>          // For the background job queue
 
 // --- Data Structures ---
 
 // Stores overall system CPU times from /proc/stat
 struct SysCpuTimes {
-    long long user;
-    long long nice;
+    int cpu;         // Core number, or -1 for the aggregate "cpu" line
+    long long user;  // Includes guest
+    long long nice;  // Includes guest_nice
     long long system;
     long long idle;
     long long iowait;
     long long irq;
     long long softirq;
     long long steal;
-    long long total; // Calculated total
+    long long guest;
+    long long guest_nice;
+    long long total; // Calculated total (guest time is already inside user/nice)
+};
+
+// Everything we read from /proc/stat in one go
+struct ProcStat {
+    SysCpuTimes cpu;                 // Aggregate over all cores
+    std::vector<SysCpuTimes> cores;  // Per-core lines, in file order
+    long long ctxt;                  // Context switches since boot
+    long long intr;                  // Interrupts since boot (all sources)
+    long long processes;             // Forks since boot
+    long procsRunning;               // Runnable right now
+    long procsBlocked;               // Waiting on I/O right now
+    double time;                     // Monotonic time of the sample
+};
+
+// Load, run queue and scheduler activity for the header
+struct SchedActivity {
+    double load1, load5, load15;
+    long runnable;      // Runnable entities, from /proc/loadavg
+    long threads;       // All entities (threads), from /proc/loadavg
+    long procsRunning;
+    long procsBlocked;
+    double ctxtRate;    // Per second
+    double intrRate;
+    double forkRate;
+};
+
+// CPU time per mode over an interval, as % of that interval
+struct CpuBreakdown {
+    int cpu;         // Core number, or -1 for the aggregate
+    double user;     // Excluding guest
+    double nice;     // Excluding guest_nice
+    double system;
+    double irq;      // irq + softirq
+    double iowait;
+    double steal;
+    double guest;    // guest + guest_nice
+    double busy;     // Everything but idle (iowait counts as busy, as before)
+};
+
+// The full /proc/[pid]/stat record, fields 3-52 as numbered in proc(5).
+// Times are in clock ticks, addresses and signal masks as printed.
+struct PidStat {
+    char state;                 // (3) R, S, D, Z, T, ...
+    int ppid;                   // (4)
+    int pgrp;
+    int session;
+    int ttyNr;
+    int tpgid;
+    long long flags;            // (9) PF_* flags
+    long long minflt;           // (10) Page faults without I/O
+    long long cminflt;
+    long long majflt;           // (12) Page faults that needed I/O
+    long long cmajflt;
+    long long utime;            // (14) CPU time (user)
+    long long stime;            // (15) CPU time (system)
+    long long cutime;           // Of waited-for children
+    long long cstime;
+    long long priority;         // (18)
+    long long nice;
+    long long numThreads;       // (20)
+    long long itrealvalue;      // Always 0
+    long long starttime;        // (22) Clock ticks after boot (pid+starttime identifies a process)
+    long long vsize;            // Bytes
+    long long rss;              // Pages
+    long long rsslim;
+    long long startcode, endcode, startstack, kstkesp, kstkeip;  // (26)-(30), 0 unless permitted
+    long long signal, blocked, sigignore, sigcatch;              // (31)-(34), obsolete bitmaps
+    long long wchan;            // (35) 0 unless permitted
+    long long nswap, cnswap;    // Not maintained
+    int exitSignal;             // (38)
+    int processor;              // (39) CPU the task last ran on
+    long long rtPriority;       // (40)
+    long long policy;           // SCHED_* policy
+    long long delayacctBlkioTicks; // (42)
+    long long guestTime;
+    long long cguestTime;
+    long long startData, endData, startBrk, argStart, argEnd, envStart, envEnd; // (45)-(51)
+    int exitCode;               // (52)
+};
+
+// p50/p95/p99/max of one metric over the histogram window
+struct Percentiles {
+    double p50, p95, p99, max;
 };
 
 // Stores all information for a single process
 struct Process {
     int pid;
+    PidStat stat;      // Everything from /proc/[pid]/stat
     std::string user;
     std::string name;
     double cpuPercent;
     double memPercent;
     long memRssKb;     // Memory in KB
-    long long utime;   // CPU time (user)
-    long long stime;   // CPU time (system)
+    long rssAnonKb;    // VmRSS split: anonymous (heap, stack),
+    long rssFileKb;    // file-backed (binaries, mapped files),
+    long rssShmemKb;   // and shared memory (tmpfs, SysV, shared anonymous)
+    long swapKb;       // VmSwap
+    int smapsState;    // SmapsState; PSS/USS are only read for rows on screen
+    long pssKb;
+    long ussKb;
+    double smapsAge;   // Seconds since PSS/USS were read
+    std::string affinity;  // Cpus_allowed_list, e.g. "0-3,8"
+    int migrations;        // CPU changes seen between refreshes since we first saw the process
+    bool migratedNow;      // On a different CPU than at the previous refresh
+    std::string service; // systemd unit or container the process belongs to
+    int ioState;          // IO_NOT_COLLECTED, IO_OK or IO_DENIED
+    double ioReadRate;    // /proc/[pid]/io read_bytes per second
+    double ioWriteRate;   // /proc/[pid]/io write_bytes per second
+    double syscrRate;     // Read syscalls per second
+    double syscwRate;     // Write syscalls per second
+    int delayState;       // DELAY_NOT_COLLECTED, DELAY_TASKSTATS or DELAY_SCHEDSTAT
+    double cpuDelayPercent;       // % of wall time spent runnable but waiting for a CPU
+    double blkioDelayPercent;     // % of wall time waiting for block I/O
+    double swapinDelayPercent;    // % of wall time waiting for swap-in
+    double freepagesDelayPercent; // % of wall time in direct memory reclaim
+    bool schedOk;                 // /proc/[pid]/schedstat was read (needs CONFIG_SCHEDSTATS)
+    double schedWaitPercent;      // % of wall time runnable but waiting on a run queue (all threads)
+    double slicesRate;            // Timeslices run per second
+    double voluntaryCsRate;       // Context switches per second: blocked (sleep, I/O, locks)
+    double involuntaryCsRate;     // ... preempted while still runnable (CPU contention)
+    double minfltRate;            // Page faults per second served from memory
+    double majfltRate;            // Page faults per second that needed I/O (swap-in, file read)
+    bool majfltSpike;             // majfltRate well above this process's own recent average
+    double rssGrowthKbPerSec;     // Slope of RSS over time (exponentially weighted least squares)
+    double rssGrowthFit;          // R^2 of that fit: near 1 when growth is steady rather than noisy
+    double rssObservedSeconds;    // How long the process has been sampled
+    double exhaustSeconds;        // Until MemAvailable runs out at this growth rate (0 = not growing)
+    bool leakSuspect;             // Steady growth, long enough and fast enough to matter
+    double cpuBaseline, cpuDeviation;  // This process's usual CPU% (EWMA) and its standard deviation
+    double rssBaseline, rssDeviation;  // ... and RSS in KB
+    double cpuScore, rssScore;         // Deviation from the baseline, in standard deviations
+    double anomalyScore;               // The larger of the two; 0 while the baseline warms up
+    double cpuAverage[3];              // CPU% smoothed over ~1 s, 10 s and 60 s, like the load averages
+    Percentiles cpuPercentiles;        // Over the histogram window (only while displayed or exported)
+    Percentiles rssPercentiles;        // ... in KB
+};
+
+enum IoState { IO_NOT_COLLECTED, IO_OK, IO_DENIED };
+
+// Where the delay columns came from: taskstats has all four, schedstat only the CPU delay
+enum DelayState { DELAY_NOT_COLLECTED, DELAY_TASKSTATS, DELAY_SCHEDSTAT };
+
+// Online least-squares fit of RSS over time. Older samples decay exponentially, which
+// acts as a sliding window in O(1) memory and O(1) work per sample.
+struct RssTrend {
+    double origin;        // Time of the first sample; t is measured from here
+    double lastTime;      // Time of the latest sample (0 = none yet)
+    double w, t, y, tt, ty, yy; // Decayed sums of 1, t, y, t^2, t*y, y^2
+};
+
+// One counter of a Space-Saving sketch: a command or user and what it consumed
+struct HeavyHitter {
+    char key[33];          // comm (15 chars) or user name (up to 32)
+    uint32_t hash;         // Compared before the key
+    double cpuSeconds;     // Overestimated by at most error
+    double error;          // Weight inherited from the counter it replaced
+    long peakRssKb;        // Largest RSS of one process with this key
+    unsigned processes;    // Distinct processes seen
+};
+
+// Space-Saving heavy hitters in fixed memory: when full, a new key takes over the
+// smallest counter. Any key with more than total/capacity CPU-seconds is always kept.
+struct HeavyHitterSketch {
+    std::vector<HeavyHitter> counters; // Never grows past capacity
+    size_t capacity;
+};
+
+// A process that has exited, from its taskstats exit event or, without those, its last scan
+struct ExitedProcess {
+    int pid;
+    int ppid;
+    char name[16];
+    char user[33];
+    double cpuSeconds;     // User + system over the whole lifetime
+    long peakRssKb;        // RSS high-water mark (the last scan's RSS in the fallback)
+    double lifetime;       // Seconds from start to exit
+    int exitCode;          // wait() status, -1 if unknown
+    double exitTime;       // monotonicSeconds() when the exit was recorded
+    bool scanned;          // Was in at least one process list
+};
+
+// Exponentially weighted mean and variance of one metric (floats: one per metric per process)
+struct EwmaBaseline {
+    float mean;
+    float variance;
+};
+
+// Log-linear histogram of non-negative integer samples: exact below 16, then 8 buckets per
+// power of two (at most 12.5% error). Sparse, since one process's samples fall in few buckets.
+struct LogHistogram {
+    std::vector<std::pair<uint16_t, uint16_t>> buckets; // (bucket, count), sorted by bucket
+    uint32_t count;
+    uint64_t max;      // Exact largest sample
+};
+
+// Samples of the last one to two half-windows: the current half and the one before it
+struct WindowedHistogram {
+    LogHistogram halves[2];
+    long long half;    // Which half-window halves[half % 2] is collecting
+};
+
+// Per-process state carried between refreshes, keyed by PID
+struct ProcessTrack {
+    long long starttime;   // Detects PID reuse
+    long long utime;       // Previous CPU times for delta calculation
+    long long stime;
+    int lastCpu;           // CPU it last ran on at the previous refresh
+    int migrations;        // Refreshes at which lastCpu had changed
+    unsigned seenScan;     // Last scan the PID was seen in, to prune exited processes
+    bool serviceResolved;  // /proc/[pid]/cgroup is read once per process
+    std::string service;
+    bool ioDenied;         // /proc/[pid]/io is not readable; don't retry for this process
+    double ioSampleTime;   // When the I/O counters below were read (0 = never)
+    unsigned ioSampleScan; // The scan that read them
+    long long readBytes;
+    long long writeBytes;
+    long long syscr;
+    long long syscw;
+    double delaySampleTime;       // When the delay totals below were read (0 = never)
+    long long cpuDelayNs;
+    long long blkioDelayNs;
+    long long swapinDelayNs;
+    long long freepagesDelayNs;
+    double schedSampleTime;       // When the schedstat totals below were read (0 = never)
+    long long schedWaitNs;
+    long long schedSlices;
+    double csSampleTime;          // When the context-switch counts below were read (0 = never)
+    long long voluntaryCs;
+    long long involuntaryCs;
+    double faultSampleTime;       // When the fault counts below were read (0 = never)
+    long long minflt;
+    long long majflt;
+    double majfltAverage;         // Exponentially weighted major faults per second
+    RssTrend rssTrend;
+    EwmaBaseline cpuBaseline;
+    EwmaBaseline rssBaseline;
+    unsigned short baselineSamples; // Saturates; scores start once the baseline has warmed up
+    float cpuAverage[3];          // Exponentially decayed CPU% per window (see cpuAverageWindows)
+    double cpuAverageTime;        // When they were last updated (0 = not yet)
+    WindowedHistogram cpuHistory; // CPU% samples in 0.1% units
+    WindowedHistogram rssHistory; // RSS samples in KB
+    std::string name;             // Last seen command, user, parent and RSS peak, for the
+    std::string user;             // exited list when there are no exit events
+    int ppid;
+    long peakRssKb;
+    bool exited;                  // Its exit event was accounted; the zombie may still be listed
+};
+
+// Aggregated totals for a group of processes (e.g. all processes of one user)
+struct ProcessGroup {
+    std::string key;
+    long numericKey;       // PPID/session, so numeric groupings sort numerically
+    int count;
+    double cpuPercent;
+    double memPercent;
+    long memRssKb;
+    double maxCpuPercent;  // Busiest single member
+    long maxRssKb;         // Largest single member
+    Percentiles cpuPercentiles; // Of the group's total, sampled while the group view is shown
+    Percentiles rssPercentiles;
+};
+
+const int pyramidLevels = 12;   // Bucket widths 1 s, 2 s, 4 s, ... 2048 s
+const int pyramidBuckets = 512; // Latest buckets kept per level
+
+// One bucket of a min/max pyramid level
+struct MinMaxBucket {
+    long long slot;  // Bucket number + 1 (0 = empty)
+    float min;
+    float max;
+};
+
+// Min/max of a series at every power-of-two time resolution. A sample updates one bucket
+// per level and a graph of any span reads one level, so zooming costs the same at 1 minute
+// as at 24 hours, and a 2 s spike survives as the max of a 30-minute bucket.
+struct MinMaxPyramid {
+    MinMaxBucket levels[pyramidLevels][pyramidBuckets];
+    float latest;    // Most recent sample
+};
+
+// One refresh's process list and summary, kept for stepping back in time
+struct Snapshot {
+    unsigned long long sequence;  // Increases by one per snapshot
+    time_t wallTime;
+    double monotonicTime;         // monotonicSeconds() when taken
+    CpuBreakdown cpuUsage;
+    std::vector<CpuBreakdown> coreUsage;
+    SchedActivity schedActivity;
+    long memUsed;
+    long memTotal;
+    std::vector<Process> processes;
+};
+
+// Stores kernel-side accounting for a single cgroup v2 directory
+struct Cgroup {
+    std::string path;        // Path relative to the cgroup2 mount ("/" for the root)
+    std::string name;        // Last path component
+    int depth;
+    bool hasChildren;
+    long long cpuUsageUsec;  // cpu.stat usage_usec
+    long long memCurrent;    // memory.current in bytes (-1 if not available)
+    long long memMax;        // memory.max in bytes (-1 for "max" or not available)
+    long long ioReadBytes;   // io.stat rbytes, summed over all devices
+    long long ioWriteBytes;  // io.stat wbytes, summed over all devices
+    double cpuPercent;
+    double ioReadRate;       // Bytes per second
+    double ioWriteRate;      // Bytes per second
+    double cpuPressure;      // cpu.pressure "some" avg10 (-1 if not available)
+    double memPressure;      // memory.pressure "some" avg10
+    double ioPressure;       // io.pressure "some" avg10
+};
+
+// One line ("some" or "full") of a /proc/pressure file
+struct PsiLine {
+    double avg10;
+    double avg60;
+    double avg300;
+    unsigned long long total;  // Cumulative stall time in microseconds
+    double stallRate;          // Stall milliseconds per second since the previous read
+};
+
+// Pressure stall information for one resource
+struct PsiResource {
+    const char *name;          // "cpu", "memory" or "io"
+    bool available;
+    PsiLine some;
+    PsiLine full;
+};
+
+// One line of /proc/diskstats plus rates derived from the previous sample.
+// Fixed-size so that refreshing hundreds of devices does not allocate.
+struct DiskStat {
+    char name[32];
+    unsigned major;
+    unsigned minor;
+    int kind;                     // DISK_WHOLE, DISK_PARTITION or DISK_VIRTUAL
+    unsigned long long reads;     // Completed reads
+    unsigned long long readSectors;
+    unsigned long long readMs;    // Time spent reading
+    unsigned long long writes;    // Completed writes
+    unsigned long long writeSectors;
+    unsigned long long writeMs;   // Time spent writing
+    unsigned long long ioMs;      // Time the device had I/O in flight
+    double readIops;
+    double writeIops;
+    double readBps;
+    double writeBps;
+    double awaitMs;               // Average time per completed request
+    double utilPercent;
+};
+
+enum DiskKind { DISK_UNKNOWN, DISK_WHOLE, DISK_PARTITION, DISK_VIRTUAL };
+
+// One interface from /proc/net/dev plus per-second rates (fixed-size, like DiskStat)
+struct NetStat {
+    char name[16];                // IFNAMSIZ
+    bool isVirtual;               // veth, bridges, lo, tunnels: anything not backed by a device
+    unsigned long long rxBytes, rxPackets, rxErrors, rxDrops;
+    unsigned long long txBytes, txPackets, txErrors, txDrops;
+    double rxBps, txBps;
+    double rxPps, txPps;
+    double dropsPerSec;           // RX + TX
+    double errorsPerSec;          // RX + TX
+};
+
+// One NUMA node: memory from node*/meminfo (kB) and allocation counters from numastat (pages)
+struct NumaNode {
+    int id;
+    long memTotal;
+    long memFree;
+    long filePages;
+    long anonPages;
+    unsigned long long numaHit;      // Allocated here as intended
+    unsigned long long numaMiss;     // Allocated here, but meant for another node
+    unsigned long long numaForeign;  // Meant for here, allocated elsewhere
+    unsigned long long localNode;    // Allocated here by a process running here
+    unsigned long long otherNode;    // Allocated here by a process running elsewhere
+    double hitRate, missRate, foreignRate, otherRate; // Pages per second
+};
+
+// Where one process's memory lives, summed from /proc/[pid]/numa_maps
+struct NumaPlacement {
+    int pid;
+    bool ok;                         // false if numa_maps could not be read
+    std::vector<long long> kbPerNode; // Indexed by node id
+    double time;                     // When it was read (monotonic)
+};
+
+enum SmapsState { SMAPS_NOT_READ, SMAPS_OK, SMAPS_DENIED, SMAPS_GONE };
+
+// PSS/USS from /proc/[pid]/smaps_rollup, read in the background
+struct SmapsRollup {
+    long long starttime;   // Of the process it was read for (PID reuse)
+    int state;             // SmapsState
+    long pssKb;            // Proportional set size: shared pages split between their users
+    long ussKb;            // Unique set size: pages only this process maps (freed if it exits)
+    long swapPssKb;
+    double time;           // When it was read (monotonic)
+};
+
+// One row of /proc/interrupts or /proc/softirqs; per-CPU counts live in a separate matrix
+struct IrqSource {
+    char name[16];                // IRQ number or name: "24", "LOC", "NET_RX"
+    char desc[48];                // Controller and device, e.g. "PCI-MSIX-0000:00:06.0 0-edge virtio5-input.0"
+    bool softirq;
+    double totalRate;             // Per second, summed over CPUs
+    double maxRate;               // Busiest CPU
+    int maxCpu;
+};
+
+// The parts of /proc/meminfo we display, in kB
+struct MemInfo {
+    long memTotal;
+    long memFree;
+    long memAvailable;
+    long buffers;
+    long cached;
+    long swapCached;
+    long active;
+    long inactive;
+    long dirty;
+    long writeback;
+    long anonPages;
+    long mapped;
+    long shmem;
+    long slab;
+    long sReclaimable;
+    long sUnreclaim;
+    long pageTables;
+    long swapTotal;
+    long swapFree;
+    long anonHugePages;
+    long commitLimit;
+    long committedAs;
+};
+
+// Cumulative event counters from /proc/vmstat
+struct VmStat {
+    unsigned long long pgfault;
+    unsigned long long pgmajfault;
+    unsigned long long pswpin;
+    unsigned long long pswpout;
+    unsigned long long pgpgin;     // KB paged in from disk
+    unsigned long long pgpgout;
+    unsigned long long pgscanKswapd;
+    unsigned long long pgscanDirect;
+    unsigned long long oomKill;
 };
 
 // --- Global Variables ---
-enum SortMode { BY_CPU, BY_MEM, BY_PID };
+enum SortMode { BY_CPU, BY_MEM, BY_PID, BY_IO_READ, BY_IO_WRITE, BY_SYSCR, BY_SYSCW,
+                BY_IO_DELAY, BY_CPU_DELAY, BY_MIGRATIONS, BY_SCHED_WAIT, BY_NVCSW, BY_VCSW,
+                BY_MINFLT, BY_MAJFLT, BY_RSS_GROWTH, BY_ANOMALY,
+                BY_CPU_1S, BY_CPU_10S, BY_CPU_60S, SORT_MODE_COUNT };
 SortMode currentSortMode = BY_CPU;
 
-// Maps to store previous CPU times for delta calculation
-std::map<int, std::pair<long long, long long>> prevProcessTimes;
-SysCpuTimes prevSysCpuTimes = {0};
+// Optional column sets shown between MEM% and COMMAND ('f' cycles)
+enum ColumnSet { COLS_DEFAULT, COLS_IO, COLS_CPU, COLS_SCHED, COLS_FAULTS, COLS_MEMORY, COLS_LEAK, COLS_ANOMALY, COLS_CPU_AVERAGE,
+                 COLS_PERCENTILES, COLUMN_SET_COUNT };
+ColumnSet currentColumnSet = COLS_DEFAULT;
+
+enum ViewMode { VIEW_PROCESSES, VIEW_CGROUPS, VIEW_GROUPS, VIEW_IOTOP, VIEW_INTERRUPTS, VIEW_CORES, VIEW_TOP_CONSUMERS, VIEW_EXITED,
+                VIEW_GRAPHS };
+ViewMode currentView = VIEW_PROCESSES;
+
+enum GroupBy { GROUP_BY_SERVICE, GROUP_BY_USER, GROUP_BY_COMM, GROUP_BY_PPID, GROUP_BY_SESSION };
+GroupBy currentGroupBy = GROUP_BY_SERVICE;
+
+bool showServiceColumn = false;
+bool showDiskPanel = false;
+bool showAllDisks = false;   // Include partitions and dm/md/loop layers in the disk panel
+
+bool showNetPanel = false;
+bool showPsiPanel = false;
+bool showMemPanel = false;
+bool showPerCoreCpu = false;
+bool hideVirtualNet = false; // Hide veth, bridges and other virtual interfaces entirely
+
+int listHeaderRow = 4;       // Row of the list column header, below the summary panels
+
+// Per-process state (previous CPU times, cached attribution) for delta calculation
+std::unordered_map<int, ProcessTrack> processTracks;
+unsigned processScanCount = 0;
+const double clockTicksPerSecond = (double)sysconf(_SC_CLK_TCK);
+ProcStat prevProcStat;
+
+// Total system CPU time at the last process scan (scans are skipped in the cgroup view)
+long long prevProcessScanCpuTotal = 0;
 
 // Map to cache Usernames (UID -> Username)
 std::map<uid_t, std::string> usernameCache;
 
+// cgroup v2 state: counters from the previous walk, collapsed subtrees and cursor
+std::string cgroupMount;
+std::unordered_map<std::string, Cgroup> prevCgroups;
+double prevCgroupSampleTime = 0.0;
+std::set<std::string> collapsedCgroups;
+int cgroupCursor = 0;
+int cgroupScroll = 0;
+
+// Process list selection (Up/Down), followed by PID across re-sorts; -1 = none
+int selectedPid = -1;
+std::vector<int> listedPids; // PIDs in the order last drawn
+std::vector<int> visiblePids; // The ones that fit on screen
+std::string processFilter;    // '/': only list processes whose name contains this
+
+// PSS/USS of visible rows are re-read when older than this
+const double smapsMaxAgeSeconds = 10.0;
+
+bool showNumaPanel = false;
+
+// Wakes waitForEvent() when the background reader has a result
+int workerWakePipe[2] = {-1, -1};
+
+// --- File Reading Helpers ---
+
+/**
+ * @brief Reads a whole /proc or /sys file with a single open/read/close
+ * @param path File to read
+ * @param buf Reusable buffer, grown as needed and NUL-terminated
+ * @return Number of bytes read, or -1 if the file could not be read
+ */
+ssize_t readFile(const char *path, std::string &buf) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    if (buf.size() < 4096) buf.resize(4096);
+
+    size_t len = 0;
+    while (true) {
+        ssize_t n = read(fd, &buf[len], buf.size() - len - 1);
+        if (n < 0) {
+            close(fd);
+            return -1;
+        }
+        if (n == 0) break;
+        len += n;
+        if (len + 1 >= buf.size()) buf.resize(buf.size() * 2);
+    }
+    close(fd);
+    buf[len] = '\0';
+    return (ssize_t)len;
+}
+
+/**
+ * @brief Parses an unsigned decimal number, advancing the cursor past it
+ */
+unsigned long long parseNumber(const char *&p) {
+    while (*p == ' ' || *p == '\t') ++p;
+    unsigned long long value = 0;
+    while (*p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        ++p;
+    }
+    return value;
+}
+
+/**
+ * @brief Seconds on the monotonic clock, for computing rates between samples
+ */
+double monotonicSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/**
+ * @brief Formats a byte count with a binary unit suffix (e.g. "12.5M")
+ */
+std::string formatBytes(double bytes) {
+    const char *units = "BKMGTP";
+    int u = 0;
+    while (bytes >= 1024.0 && u < 5) {
+        bytes /= 1024.0;
+        ++u;
+    }
+    char buf[16];
+    snprintf(buf, sizeof(buf), (u == 0) ? "%.0f%c" : "%.1f%c", bytes, units[u]);
+    return buf;
+}
+
+/**
+ * @brief Formats a duration with its two largest units (e.g. "45s", "3h12m", "2d4h")
+ */
+std::string formatDuration(double seconds) {
+    char buf[24];
+    long long s = (long long)seconds;
+    if (s < 60) snprintf(buf, sizeof(buf), "%llds", s);
+    else if (s < 3600) snprintf(buf, sizeof(buf), "%lldm%02llds", s / 60, s % 60);
+    else if (s < 86400) snprintf(buf, sizeof(buf), "%lldh%02lldm", s / 3600, (s % 3600) / 60);
+    else if (s < 100LL * 86400) snprintf(buf, sizeof(buf), "%lldd%lldh", s / 86400, (s % 86400) / 3600);
+    else snprintf(buf, sizeof(buf), ">100d");
+    return buf;
+}
+
 // --- Parsing Functions ---
 
 /**
@@ -96,318 +691,4303 @@ std::string getUsername(int pid) {
     return "unknown"; // Should be in cache, but fallback
 }
 
+// --- Key Lookup (compile-time perfect hash) ---
+
 /**
- * @brief Reads /proc/meminfo to get system memory
- * @return A pair of <Total Memory KB, Available Memory KB>
+ * @brief FNV-1a hash of a key, perturbed by a seed
  */
-std::pair<long, long> getMemoryInfo() {
-    std::ifstream file("/proc/meminfo");
-    std::string line;
-    long memTotal = 0;
-    long memAvailable = 0;
+constexpr uint32_t hashKey(const char *key, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (size_t i = 0; i < len; ++i) {
+        h ^= (unsigned char)key[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+constexpr size_t constLength(const char *s) {
+    size_t len = 0;
+    while (s[len]) ++len;
+    return len;
+}
+
+// Maps each of N keys to its own slot; slots[] holds key index + 1 (0 = no key)
+template <size_t N, size_t TableSize>
+struct PerfectHash {
+    uint32_t seed;
+    unsigned char slots[TableSize];
+};
+
+/**
+ * @brief Searches, at compile time, for a seed under which no two keys collide
+ * @return The table, or one with seed 0 if no seed was found (checked by static_assert)
+ */
+template <size_t TableSize, size_t N>
+constexpr PerfectHash<N, TableSize> buildPerfectHash(const char *const (&keys)[N]) {
+    PerfectHash<N, TableSize> table = {};
+    for (uint32_t seed = 1; seed < 10000; ++seed) {
+        unsigned char slots[TableSize] = {};
+        bool collision = false;
+        for (size_t i = 0; i < N && !collision; ++i) {
+            uint32_t slot = hashKey(keys[i], constLength(keys[i]), seed) % TableSize;
+            collision = slots[slot] != 0;
+            slots[slot] = (unsigned char)(i + 1);
+        }
+        if (!collision) {
+            table.seed = seed;
+            for (size_t i = 0; i < TableSize; ++i) table.slots[i] = slots[i];
+            return table;
+        }
+    }
+    return table;
+}
+
+/**
+ * @brief Parses a "key<sep> value" file in one pass, storing the values of known keys.
+ *        Each line costs one hash and at most one key comparison; nothing is allocated.
+ * @param store Called as store(keyIndex, value) for every known key
+ */
+template <size_t N, size_t TableSize, typename Store>
+void parseKeyValues(const char *p, char separator, const char *const (&keys)[N],
+                    const PerfectHash<N, TableSize> &table, Store store) {
+    while (*p) {
+        const char *key = p;
+        while (*p && *p != separator && *p != '\n') ++p;
+        size_t len = p - key;
+        if (*p == separator) {
+            ++p;
+            unsigned index = table.slots[hashKey(key, len, table.seed) % TableSize];
+            if (index != 0 && constLength(keys[index - 1]) == len && memcmp(keys[index - 1], key, len) == 0) {
+                store(index - 1, parseNumber(p));
+            }
+        }
+        while (*p && *p != '\n') ++p;
+        if (*p == '\n') ++p;
+    }
+}
+
+// /proc/meminfo keys, in the same order as the MemInfo members they fill
+constexpr const char *memInfoKeys[] = {
+    "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "SwapCached", "Active", "Inactive",
+    "Dirty", "Writeback", "AnonPages", "Mapped", "Shmem", "Slab", "SReclaimable", "SUnreclaim",
+    "PageTables", "SwapTotal", "SwapFree", "AnonHugePages", "CommitLimit", "Committed_AS",
+};
+constexpr long MemInfo::*memInfoFields[] = {
+    &MemInfo::memTotal, &MemInfo::memFree, &MemInfo::memAvailable, &MemInfo::buffers, &MemInfo::cached,
+    &MemInfo::swapCached, &MemInfo::active, &MemInfo::inactive, &MemInfo::dirty, &MemInfo::writeback,
+    &MemInfo::anonPages, &MemInfo::mapped, &MemInfo::shmem, &MemInfo::slab, &MemInfo::sReclaimable,
+    &MemInfo::sUnreclaim, &MemInfo::pageTables, &MemInfo::swapTotal, &MemInfo::swapFree,
+    &MemInfo::anonHugePages, &MemInfo::commitLimit, &MemInfo::committedAs,
+};
+constexpr auto memInfoHash = buildPerfectHash<128>(memInfoKeys);
+static_assert(memInfoHash.seed != 0, "no collision-free seed for the meminfo keys");
+static_assert(sizeof(memInfoKeys) / sizeof(memInfoKeys[0]) == sizeof(memInfoFields) / sizeof(memInfoFields[0]),
+              "every meminfo key needs a MemInfo member");
+
+// /proc/vmstat keys, in the same order as the VmStat members they fill
+constexpr const char *vmStatKeys[] = {
+    "pgfault", "pgmajfault", "pswpin", "pswpout", "pgpgin", "pgpgout", "pgscan_kswapd", "pgscan_direct",
+    "oom_kill",
+};
+constexpr unsigned long long VmStat::*vmStatFields[] = {
+    &VmStat::pgfault, &VmStat::pgmajfault, &VmStat::pswpin, &VmStat::pswpout, &VmStat::pgpgin,
+    &VmStat::pgpgout, &VmStat::pgscanKswapd, &VmStat::pgscanDirect, &VmStat::oomKill,
+};
+constexpr auto vmStatHash = buildPerfectHash<64>(vmStatKeys);
+static_assert(vmStatHash.seed != 0, "no collision-free seed for the vmstat keys");
+static_assert(sizeof(vmStatKeys) / sizeof(vmStatKeys[0]) == sizeof(vmStatFields) / sizeof(vmStatFields[0]),
+              "every vmstat key needs a VmStat member");
+
+/**
+ * @brief Reads /proc/meminfo in a single pass into a MemInfo
+ */
+MemInfo getMemoryInfo() {
+    static std::string buf;
+    MemInfo info = {};
+    if (readFile("/proc/meminfo", buf) > 0) {
+        parseKeyValues(buf.c_str(), ':', memInfoKeys, memInfoHash,
+                       [&](size_t index, unsigned long long value) { info.*memInfoFields[index] = (long)value; });
+    }
+    return info;
+}
+
+/**
+ * @brief Reads the event counters we track from /proc/vmstat
+ */
+VmStat getVmStat() {
+    static std::string buf;
+    VmStat stat = {};
+    if (readFile("/proc/vmstat", buf) > 0) {
+        parseKeyValues(buf.c_str(), ' ', vmStatKeys, vmStatHash,
+                       [&](size_t index, unsigned long long value) { stat.*vmStatFields[index] = value; });
+    }
+    return stat;
+}
+
+// vmstat counters from the last two refreshes, for per-second rates
+VmStat vmStat = {};
+VmStat prevVmStat = {};
+double vmStatElapsed = 0.0;
+double prevVmStatTime = 0.0;
+
+/**
+ * @brief Samples /proc/vmstat, keeping the previous sample for rates
+ */
+void updateVmStat() {
+    double now = monotonicSeconds();
+    prevVmStat = vmStat;
+    vmStat = getVmStat();
+    vmStatElapsed = (prevVmStatTime > 0.0) ? now - prevVmStatTime : 0.0;
+    prevVmStatTime = now;
+}
+
+/**
+ * @brief Reads /proc/stat once: the aggregate and per-core CPU times, and the
+ *        ctxt/intr/processes counters and procs_running/procs_blocked below them.
+ *        Older kernels report fewer fields per line; missing ones stay 0.
+ */
+ProcStat getProcStat() {
+    static std::string buf;
+    ProcStat stat = {};
+    stat.cpu.cpu = -1;
+    stat.time = monotonicSeconds();
+    if (readFile("/proc/stat", buf) <= 0) return stat;
+
+    const char *p = buf.c_str();
+    while (*p) {
+        if (strncmp(p, "cpu", 3) == 0) {
+            p += 3;
+            SysCpuTimes t = {};
+            t.cpu = (*p >= '0' && *p <= '9') ? (int)parseNumber(p) : -1;
+            long long *fields[] = {&t.user, &t.nice, &t.system, &t.idle, &t.iowait, &t.irq,
+                                   &t.softirq, &t.steal, &t.guest, &t.guest_nice};
+            for (long long *field : fields) {
+                while (*p == ' ') ++p;
+                if (*p < '0' || *p > '9') break;
+                *field = (long long)parseNumber(p);
+            }
+            // guest/guest_nice are already counted in user/nice, so they are not added again
+            t.total = t.user + t.nice + t.system + t.idle + t.iowait + t.irq + t.softirq + t.steal;
+            if (t.cpu < 0) {
+                stat.cpu = t;
+            } else {
+                stat.cores.push_back(t);
+            }
+        } else {
+            // Single-counter lines; "intr" continues with one count per IRQ, skipped below
+            struct { const char *key; size_t len; long long *value; } counters[] = {
+                {"ctxt ", 5, &stat.ctxt},
+                {"intr ", 5, &stat.intr},
+                {"processes ", 10, &stat.processes},
+            };
+            for (const auto &c : counters) {
+                if (strncmp(p, c.key, c.len) == 0) {
+                    p += c.len;
+                    *c.value = (long long)parseNumber(p);
+                }
+            }
+            if (strncmp(p, "procs_running ", 14) == 0) {
+                p += 14;
+                stat.procsRunning = (long)parseNumber(p);
+            } else if (strncmp(p, "procs_blocked ", 14) == 0) {
+                p += 14;
+                stat.procsBlocked = (long)parseNumber(p);
+            }
+        }
+        while (*p && *p != '\n') ++p;
+        if (*p == '\n') ++p;
+    }
+    return stat;
+}
+
+/**
+ * @brief Combines /proc/loadavg with the /proc/stat counters, as rates between two samples
+ */
+SchedActivity getSchedActivity(const ProcStat &current, const ProcStat &prev) {
+    static std::string buf;
+    SchedActivity a = {};
+    if (readFile("/proc/loadavg", buf) > 0) {
+        // "0.52 0.58 0.59 2/1234 56789"
+        char *end = nullptr;
+        a.load1 = strtod(buf.c_str(), &end);
+        a.load5 = strtod(end, &end);
+        a.load15 = strtod(end, &end);
+        const char *p = end;
+        while (*p == ' ') ++p;
+        a.runnable = (long)parseNumber(p);
+        if (*p == '/') ++p;
+        a.threads = (long)parseNumber(p);
+    }
+    a.procsRunning = current.procsRunning;
+    a.procsBlocked = current.procsBlocked;
+
+    double elapsed = current.time - prev.time;
+    if (elapsed > 0.0 && prev.time > 0.0) {
+        a.ctxtRate = std::max(0.0, (double)(current.ctxt - prev.ctxt) / elapsed);
+        a.intrRate = std::max(0.0, (double)(current.intr - prev.intr) / elapsed);
+        a.forkRate = std::max(0.0, (double)(current.processes - prev.processes) / elapsed);
+    }
+    return a;
+}
+
+/**
+ * @brief Splits the CPU time between two samples into per-mode percentages
+ */
+CpuBreakdown getCpuBreakdown(const SysCpuTimes &current, const SysCpuTimes &prev) {
+    CpuBreakdown b = {};
+    b.cpu = current.cpu;
+    long long totalDelta = current.total - prev.total;
+    if (totalDelta <= 0) return b; // No time passed, or the counters went backwards (hotplug)
+
+    auto percent = [&](long long delta) { return std::max(0.0, 100.0 * (double)delta / (double)totalDelta); };
+    long long guestDelta = current.guest - prev.guest;
+    long long guestNiceDelta = current.guest_nice - prev.guest_nice;
+    b.user = percent((current.user - prev.user) - guestDelta);
+    b.nice = percent((current.nice - prev.nice) - guestNiceDelta);
+    b.system = percent(current.system - prev.system);
+    b.irq = percent((current.irq - prev.irq) + (current.softirq - prev.softirq));
+    b.iowait = percent(current.iowait - prev.iowait);
+    b.steal = percent(current.steal - prev.steal);
+    b.guest = percent(guestDelta + guestNiceDelta);
+    b.busy = 100.0 - percent(current.idle - prev.idle);
+    return b;
+}
+
+/**
+ * @brief Parses a possibly negative decimal number and advances p past it
+ */
+long long parseSignedNumber(const char *&p) {
+    while (*p == ' ') ++p;
+    bool negative = (*p == '-');
+    if (negative) ++p;
+    long long value = (long long)parseNumber(p);
+    return negative ? -value : value;
+}
+
+/**
+ * @brief Parses a /proc/[pid]/stat line into its full record. comm (2) may contain
+ *        spaces and parentheses, so the fields start after the last ')'. Kernels that
+ *        print fewer fields leave the rest 0.
+ * @return false if the line is not a stat record
+ */
+bool parsePidStat(const char *line, PidStat &s) {
+    const char *p = strrchr(line, ')');
+    if (!p) return false;
+    ++p;
+    while (*p == ' ') ++p;
+    s = PidStat();
+    s.state = *p ? *p++ : '?';
+
+    long long ppid, pgrp, session, ttyNr, tpgid, exitSignal, processor, exitCode;
+    long long *fields[] = {
+        &ppid, &pgrp, &session, &ttyNr, &tpgid, &s.flags,
+        &s.minflt, &s.cminflt, &s.majflt, &s.cmajflt, &s.utime, &s.stime, &s.cutime, &s.cstime,
+        &s.priority, &s.nice, &s.numThreads, &s.itrealvalue, &s.starttime, &s.vsize, &s.rss, &s.rsslim,
+        &s.startcode, &s.endcode, &s.startstack, &s.kstkesp, &s.kstkeip,
+        &s.signal, &s.blocked, &s.sigignore, &s.sigcatch, &s.wchan, &s.nswap, &s.cnswap,
+        &exitSignal, &processor, &s.rtPriority, &s.policy, &s.delayacctBlkioTicks, &s.guestTime, &s.cguestTime,
+        &s.startData, &s.endData, &s.startBrk, &s.argStart, &s.argEnd, &s.envStart, &s.envEnd, &exitCode,
+    };
+    for (long long *field : fields) *field = 0;
+    for (long long *field : fields) {
+        while (*p == ' ') ++p;
+        if (*p != '-' && (*p < '0' || *p > '9')) break;
+        *field = parseSignedNumber(p);
+    }
+    s.ppid = (int)ppid;
+    s.pgrp = (int)pgrp;
+    s.session = (int)session;
+    s.ttyNr = (int)ttyNr;
+    s.tpgid = (int)tpgid;
+    s.exitSignal = (int)exitSignal;
+    s.processor = (int)processor;
+    s.exitCode = (int)exitCode;
+    return true;
+}
+
+/**
+ * @brief Maps a cgroup path to the systemd unit or container that owns it
+ * @param path e.g. "/system.slice/nginx.service" or
+ *        "/kubepods.slice/.../cri-containerd-<64 hex id>.scope"
+ * @return "nginx.service", "containerd:<12 hex>", ... or "-" for the root cgroup
+ */
+std::string cgroupPathToService(const std::string &path) {
+    if (path.empty() || path == "/") return "-";
+
+    // Walk the components from the leaf upwards, looking for a container ID first
+    std::vector<std::string> parts;
+    std::stringstream ss(path);
+    std::string part;
+    while (std::getline(ss, part, '/')) {
+        if (!part.empty()) parts.push_back(part);
+    }
+
+    static const std::pair<const char *, const char *> runtimes[] = {
+        {"docker-", "docker"}, {"cri-containerd-", "containerd"}, {"crio-", "crio"},
+        {"libpod-", "podman"}, {"containerd-", "containerd"},
+    };
+    for (int i = (int)parts.size() - 1; i >= 0; --i) {
+        std::string id = parts[i];
+        std::string runtime;
+        for (const auto &r : runtimes) {
+            if (id.rfind(r.first, 0) == 0) {
+                id = id.substr(strlen(r.first));
+                runtime = r.second;
+                break;
+            }
+        }
+        if (id.size() > 6 && id.compare(id.size() - 6, 6, ".scope") == 0) {
+            id.erase(id.size() - 6);
+        }
+        bool isHex = id.size() >= 32 &&
+                     id.find_first_not_of("0123456789abcdef") == std::string::npos;
+        if (isHex) {
+            if (runtime.empty()) {
+                // cgroupfs driver layouts: /docker/<id>, /kubepods/<qos>/pod<uid>/<id>
+                runtime = (path.find("kubepods") != std::string::npos) ? "k8s" : "docker";
+            }
+            return runtime + ":" + id.substr(0, 12);
+        }
+    }
+
+    // Otherwise the innermost systemd unit (service, scope or slice)
+    for (int i = (int)parts.size() - 1; i >= 0; --i) {
+        const std::string &unit = parts[i];
+        size_t dot = unit.rfind('.');
+        if (dot == std::string::npos) continue;
+        std::string suffix = unit.substr(dot);
+        if (suffix == ".service" || suffix == ".scope" || suffix == ".slice") {
+            return unit;
+        }
+    }
+    return path; // Not managed by systemd or a container runtime
+}
+
+/**
+ * @brief Reads /proc/[pid]/cgroup and attributes the process to a service or container
+ */
+std::string getProcessService(int pid) {
+    std::ifstream file("/proc/" + std::to_string(pid) + "/cgroup");
+    if (!file.is_open()) return "n/a";
 
+    // Prefer the unified (v2) hierarchy, falling back to the v1 name=systemd one
+    std::string line, unifiedPath, systemdPath;
     while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string key;
-        long value;
-        ss >> key >> value;
-        if (key == "MemTotal:") {
-            memTotal = value;
-        } else if (key == "MemAvailable:") {
-            memAvailable = value;
-        }
-        if (memTotal > 0 && memAvailable > 0) {
-            break;
+        if (line.rfind("0::", 0) == 0) {
+            unifiedPath = line.substr(3);
+        } else if (line.find(":name=systemd:") != std::string::npos) {
+            systemdPath = line.substr(line.find(":name=systemd:") + 14);
+        }
+    }
+    if (unifiedPath.empty() || (unifiedPath == "/" && !systemdPath.empty())) {
+        unifiedPath = systemdPath;
+    }
+    return cgroupPathToService(unifiedPath);
+}
+
+/**
+ * @brief /proc/[pid]/io is only read while an I/O column or sort is active
+ */
+bool ioCollectionActive() {
+    return currentColumnSet == COLS_IO || currentView == VIEW_IOTOP ||
+           (currentSortMode >= BY_IO_READ && currentSortMode <= BY_SYSCW);
+}
+
+/**
+ * @brief Reads /proc/[pid]/io and computes I/O rates against the previous read.
+ *        Processes we may not read are marked once and skipped from then on.
+ */
+void readProcessIo(int pid, Process &p, ProcessTrack &track, double now) {
+    if (track.ioDenied) {
+        p.ioState = IO_DENIED;
+        return;
+    }
+
+    static std::string buf;
+    std::string path = "/proc/" + std::to_string(pid) + "/io";
+    if (readFile(path.c_str(), buf) < 0) {
+        if (errno == EACCES || errno == EPERM) {
+            track.ioDenied = true;
+            p.ioState = IO_DENIED;
+        }
+        return;
+    }
+
+    long long readBytes = 0, writeBytes = 0, syscr = 0, syscw = 0;
+    const char *s = buf.c_str();
+    if (const char *v = strstr(s, "syscr: ")) syscr = strtoll(v + 7, NULL, 10);
+    if (const char *v = strstr(s, "syscw: ")) syscw = strtoll(v + 7, NULL, 10);
+    if (const char *v = strstr(s, "\nread_bytes: ")) readBytes = strtoll(v + 13, NULL, 10);
+    if (const char *v = strstr(s, "\nwrite_bytes: ")) writeBytes = strtoll(v + 14, NULL, 10);
+
+    // Counters from before a gap in collection would spread the bytes over the whole gap:
+    // start a new baseline and show no rate until the next refresh
+    double elapsed = now - track.ioSampleTime;
+    if (track.ioSampleTime > 0.0 && elapsed > 0.0 && track.ioSampleScan + 1 == processScanCount) {
+        p.ioState = IO_OK;
+        p.ioReadRate = (double)(readBytes - track.readBytes) / elapsed;
+        p.ioWriteRate = (double)(writeBytes - track.writeBytes) / elapsed;
+        p.syscrRate = (double)(syscr - track.syscr) / elapsed;
+        p.syscwRate = (double)(syscw - track.syscw) / elapsed;
+    }
+    track.ioSampleTime = now;
+    track.ioSampleScan = processScanCount;
+    track.readBytes = readBytes;
+    track.writeBytes = writeBytes;
+    track.syscr = syscr;
+    track.syscw = syscw;
+}
+
+// --- Delay Accounting (taskstats, with a /proc fallback) ---
+
+// Generic netlink socket for the kernel's taskstats family (-1 if unavailable)
+int taskstatsSocket = -1;
+int taskstatsFamily = 0;
+bool taskstatsProbed = false;
+std::string taskstatsStatus; // Which backend the I/O view uses, and why
+
+/**
+ * @brief Appends a netlink attribute to a message
+ */
+void addNetlinkAttr(struct nlmsghdr *msg, int type, const void *data, int len) {
+    struct nlattr *attr = (struct nlattr *)((char *)msg + NLMSG_ALIGN(msg->nlmsg_len));
+    attr->nla_type = type;
+    attr->nla_len = NLA_HDRLEN + len;
+    memcpy((char *)attr + NLA_HDRLEN, data, len);
+    msg->nlmsg_len = NLMSG_ALIGN(msg->nlmsg_len) + NLA_ALIGN(attr->nla_len);
+}
+
+/**
+ * @brief Finds an attribute of the given type in a run of netlink attributes
+ */
+struct nlattr *findNetlinkAttr(char *attrs, int len, int type) {
+    while (len >= (int)sizeof(struct nlattr)) {
+        struct nlattr *attr = (struct nlattr *)attrs;
+        if (attr->nla_len < NLA_HDRLEN || attr->nla_len > len) break;
+        if ((attr->nla_type & NLA_TYPE_MASK) == type) return attr;
+        len -= NLA_ALIGN(attr->nla_len);
+        attrs += NLA_ALIGN(attr->nla_len);
+    }
+    return NULL;
+}
+
+/**
+ * @brief Looks up the dynamic ID of the "TASKSTATS" generic netlink family
+ * @return The family ID, or 0 if the kernel has no taskstats support
+ */
+int resolveTaskstatsFamily(int sock) {
+    char buf[1024] = {0};
+    struct nlmsghdr *msg = (struct nlmsghdr *)buf;
+    msg->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    msg->nlmsg_type = GENL_ID_CTRL;
+    msg->nlmsg_flags = NLM_F_REQUEST;
+    struct genlmsghdr *genl = (struct genlmsghdr *)NLMSG_DATA(msg);
+    genl->cmd = CTRL_CMD_GETFAMILY;
+    genl->version = 1;
+    addNetlinkAttr(msg, CTRL_ATTR_FAMILY_NAME, TASKSTATS_GENL_NAME, strlen(TASKSTATS_GENL_NAME) + 1);
+    if (send(sock, buf, msg->nlmsg_len, 0) < 0) return 0;
+
+    char reply[4096];
+    ssize_t len = recv(sock, reply, sizeof(reply), 0);
+    msg = (struct nlmsghdr *)reply;
+    if (len <= 0 || !NLMSG_OK(msg, (size_t)len) || msg->nlmsg_type == NLMSG_ERROR) return 0;
+
+    char *attrs = (char *)NLMSG_DATA(msg) + GENL_HDRLEN;
+    int attrsLen = msg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+    struct nlattr *id = findNetlinkAttr(attrs, attrsLen, CTRL_ATTR_FAMILY_ID);
+    return id ? *(__u16 *)((char *)id + NLA_HDRLEN) : 0;
+}
+
+/**
+ * @brief Queries taskstats for a list of thread groups. Requests are pipelined,
+ *        up to 64 per send(), and replies matched back by sequence number. Sequence
+ *        numbers keep counting across calls, so late replies to a call that timed out
+ *        are dropped instead of landing on another process's row.
+ * @param tgids Thread group (process) IDs to query
+ * @param stats Receives one record per tgid
+ * @param ok Set to 1 for each tgid that got a reply
+ * @return 0, or the errno of a failure that affects every request (e.g. EPERM)
+ */
+int queryTaskstats(const std::vector<int> &tgids, std::vector<struct taskstats> &stats, std::vector<char> &ok) {
+    const size_t batchSize = 64;
+    const size_t requestLen = NLMSG_ALIGN(NLMSG_LENGTH(GENL_HDRLEN)) + NLA_ALIGN(NLA_HDRLEN + sizeof(__u32));
+    static char sendBuf[64 * 64];
+    static char recvBuf[64 * 1024];
+    static __u32 nextSeq = 0;
+    int failure = 0;
+
+    stats.assign(tgids.size(), taskstats());
+    ok.assign(tgids.size(), 0);
+
+    for (size_t start = 0; start < tgids.size(); start += batchSize) {
+        size_t count = std::min(batchSize, tgids.size() - start);
+        __u32 firstSeq = nextSeq;
+        nextSeq += count;
+        memset(sendBuf, 0, count * requestLen);
+        for (size_t i = 0; i < count; ++i) {
+            struct nlmsghdr *msg = (struct nlmsghdr *)(sendBuf + i * requestLen);
+            msg->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+            msg->nlmsg_type = taskstatsFamily;
+            msg->nlmsg_flags = NLM_F_REQUEST;
+            msg->nlmsg_seq = firstSeq + i;
+            struct genlmsghdr *genl = (struct genlmsghdr *)NLMSG_DATA(msg);
+            genl->cmd = TASKSTATS_CMD_GET;
+            genl->version = TASKSTATS_GENL_VERSION;
+            __u32 tgid = tgids[start + i];
+            addNetlinkAttr(msg, TASKSTATS_CMD_ATTR_TGID, &tgid, sizeof(tgid));
+        }
+        if (send(taskstatsSocket, sendBuf, count * requestLen, 0) < 0) return errno;
+
+        // Each request gets exactly one reply: the stats, or an error (e.g. the process exited)
+        size_t replies = 0;
+        while (replies < count) {
+            ssize_t len = recv(taskstatsSocket, recvBuf, sizeof(recvBuf), 0);
+            if (len < 0) {
+                if (errno == EINTR) continue;
+                return (errno == EAGAIN) ? failure : errno; // EAGAIN: receive timeout
+            }
+            for (struct nlmsghdr *msg = (struct nlmsghdr *)recvBuf; NLMSG_OK(msg, (size_t)len);
+                 msg = NLMSG_NEXT(msg, len)) {
+                __u32 offset = msg->nlmsg_seq - firstSeq; // Wraps to a huge value for older replies
+                if (offset >= count) continue;
+                size_t index = start + offset;
+                replies++;
+                if (msg->nlmsg_type == NLMSG_ERROR) {
+                    int error = -((struct nlmsgerr *)NLMSG_DATA(msg))->error;
+                    if (error == EPERM || error == EACCES) failure = error;
+                    continue;
+                }
+                char *attrs = (char *)NLMSG_DATA(msg) + GENL_HDRLEN;
+                int attrsLen = msg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+                struct nlattr *aggr = findNetlinkAttr(attrs, attrsLen, TASKSTATS_TYPE_AGGR_TGID);
+                if (!aggr) continue;
+                struct nlattr *data = findNetlinkAttr((char *)aggr + NLA_HDRLEN, aggr->nla_len - NLA_HDRLEN,
+                                                      TASKSTATS_TYPE_STATS);
+                struct nlattr *tgid = findNetlinkAttr((char *)aggr + NLA_HDRLEN, aggr->nla_len - NLA_HDRLEN,
+                                                      TASKSTATS_TYPE_TGID);
+                if (!data || !tgid || *(__u32 *)((char *)tgid + NLA_HDRLEN) != (__u32)tgids[index]) continue;
+                // Older kernels send a shorter struct; newer fields stay zero
+                size_t size = std::min((size_t)(data->nla_len - NLA_HDRLEN), sizeof(struct taskstats));
+                memcpy(&stats[index], (char *)data + NLA_HDRLEN, size);
+                ok[index] = 1;
+            }
+        }
+        if (failure) return failure;
+    }
+    return failure;
+}
+
+/**
+ * @brief Opens the taskstats socket and checks that delay accounting is usable.
+ *        Kernels without (or with disabled) delay accounting fall back to /proc.
+ * @return true if taskstats should be used
+ */
+bool initTaskstats() {
+    if (taskstatsProbed) return taskstatsSocket >= 0;
+    taskstatsProbed = true;
+
+    // Since 5.14 delay accounting is off unless kernel.task_delayacct=1 (or "delayacct" boot flag)
+    std::ifstream sysctl("/proc/sys/kernel/task_delayacct");
+    int enabled = 1;
+    if (sysctl.is_open() && (sysctl >> enabled) && enabled == 0) {
+        taskstatsStatus = "/proc fallback: kernel.task_delayacct=0";
+        return false;
+    }
+
+    int sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (sock < 0) {
+        taskstatsStatus = "/proc fallback: no netlink";
+        return false;
+    }
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    struct timeval timeout = {0, 200000}; // Never let a lost reply stall the refresh
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        (taskstatsFamily = resolveTaskstatsFamily(sock)) == 0) {
+        close(sock);
+        taskstatsStatus = "/proc fallback: no taskstats in kernel";
+        return false;
+    }
+
+    // Probe with our own process: replies need CAP_NET_ADMIN, and a process that
+    // has run but shows no CPU delay samples means delay accounting is compiled out
+    taskstatsSocket = sock;
+    std::vector<struct taskstats> stats;
+    std::vector<char> ok;
+    int error = queryTaskstats({(int)getpid()}, stats, ok);
+    if (error != 0 || !ok[0] || stats[0].cpu_count == 0) {
+        close(sock);
+        taskstatsSocket = -1;
+        taskstatsStatus = (error == EPERM || error == EACCES) ? "/proc fallback: taskstats needs CAP_NET_ADMIN"
+                                                              : "/proc fallback: no delay accounting";
+        return false;
+    }
+    taskstatsStatus = "taskstats";
+    return true;
+}
+
+/**
+ * @brief Reads /proc/[pid]/schedstat: time on CPU, time waiting on a runqueue (ns),
+ *        and number of timeslices run
+ */
+bool readProcessSchedstat(int pid, long long &runNs, long long &waitNs, long long &slices) {
+    static std::string buf;
+    std::string path = "/proc/" + std::to_string(pid) + "/schedstat";
+    if (readFile(path.c_str(), buf) <= 0) return false;
+    return sscanf(buf.c_str(), "%lld %lld %lld", &runNs, &waitNs, &slices) == 3;
+}
+
+/**
+ * @brief Converts a delay total (ns) into % of wall time since the previous sample
+ */
+double delayPercent(long long currentNs, long long prevNs, double elapsed) {
+    if (elapsed <= 0.0 || currentNs < prevNs) return 0.0;
+    return 100.0 * (double)(currentNs - prevNs) / (elapsed * 1e9);
+}
+
+/**
+ * @brief Delays are only queried for the I/O view or while sorting on one
+ */
+bool delayCollectionActive() {
+    return currentView == VIEW_IOTOP || currentSortMode == BY_IO_DELAY || currentSortMode == BY_CPU_DELAY;
+}
+
+/**
+ * @brief Fills in the delay columns: batched taskstats queries when available,
+ *        otherwise only the CPU run-delay from /proc/[pid]/schedstat
+ */
+void collectDelayAccounting(std::vector<Process> &processes, double now) {
+    bool useTaskstats = initTaskstats();
+    std::vector<struct taskstats> stats;
+    std::vector<char> ok;
+    if (useTaskstats) {
+        std::vector<int> tgids;
+        tgids.reserve(processes.size());
+        for (const auto &p : processes) tgids.push_back(p.pid);
+        if (queryTaskstats(tgids, stats, ok) != 0) ok.assign(processes.size(), 0);
+    }
+
+    for (size_t i = 0; i < processes.size(); ++i) {
+        Process &p = processes[i];
+        auto it = processTracks.find(p.pid);
+        if (it == processTracks.end()) continue;
+        ProcessTrack &track = it->second;
+
+        long long cpuDelay = 0, blkioDelay = 0, swapinDelay = 0, freepagesDelay = 0;
+        if (useTaskstats) {
+            if (!ok[i]) continue;
+            cpuDelay = stats[i].cpu_delay_total;
+            blkioDelay = stats[i].blkio_delay_total;
+            swapinDelay = stats[i].swapin_delay_total;
+            freepagesDelay = stats[i].freepages_delay_total;
+            p.delayState = DELAY_TASKSTATS;
+        } else {
+            long long runNs, slices;
+            if (!readProcessSchedstat(p.pid, runNs, cpuDelay, slices)) continue;
+            p.delayState = DELAY_SCHEDSTAT;
+        }
+
+        double elapsed = now - track.delaySampleTime;
+        if (track.delaySampleTime > 0.0) {
+            p.cpuDelayPercent = delayPercent(cpuDelay, track.cpuDelayNs, elapsed);
+            p.blkioDelayPercent = delayPercent(blkioDelay, track.blkioDelayNs, elapsed);
+            p.swapinDelayPercent = delayPercent(swapinDelay, track.swapinDelayNs, elapsed);
+            p.freepagesDelayPercent = delayPercent(freepagesDelay, track.freepagesDelayNs, elapsed);
+        }
+        track.delaySampleTime = now;
+        track.cpuDelayNs = cpuDelay;
+        track.blkioDelayNs = blkioDelay;
+        track.swapinDelayNs = swapinDelay;
+        track.freepagesDelayNs = freepagesDelay;
+    }
+}
+
+/**
+ * @brief /proc/[pid]/schedstat is only read while the scheduler columns or a wait sort are active
+ */
+bool schedCollectionActive() {
+    return currentColumnSet == COLS_SCHED || currentSortMode == BY_SCHED_WAIT;
+}
+
+/**
+ * @brief Computes run-queue wait and timeslice rates from /proc/[pid]/schedstat
+ *        ("<run ns> <wait ns> <timeslices>", summed over the process's threads).
+ *        Stamped at the read itself: a scan under CPU contention can take long enough
+ *        to skew a rate against the scan's start time.
+ */
+void readProcessSchedLatency(int pid, Process &p, ProcessTrack &track) {
+    long long runNs, waitNs, slices;
+    if (!readProcessSchedstat(pid, runNs, waitNs, slices)) return;
+    double now = monotonicSeconds();
+    p.schedOk = true;
+    double elapsed = now - track.schedSampleTime;
+    if (track.schedSampleTime > 0.0 && elapsed > 0.0) {
+        p.schedWaitPercent = delayPercent(waitNs, track.schedWaitNs, elapsed);
+        p.slicesRate = std::max(0.0, (double)(slices - track.schedSlices) / elapsed);
+    }
+    track.schedSampleTime = now;
+    track.schedWaitNs = waitNs;
+    track.schedSlices = slices;
+}
+
+/**
+ * @brief Computes minor/major fault rates and flags a major fault spike: well above
+ *        the process's own moving average, and high enough to mean real I/O
+ */
+void updateFaultRates(Process &p, ProcessTrack &track, double now) {
+    const double spikeFactor = 4.0;   // Times the process's recent average
+    const double spikeMinimum = 20.0; // Major faults per second
+    const double smoothing = 0.3;     // Weight of the newest sample in the average
+
+    double elapsed = now - track.faultSampleTime;
+    if (track.faultSampleTime > 0.0 && elapsed > 0.0) {
+        p.minfltRate = std::max(0.0, (double)(p.stat.minflt - track.minflt) / elapsed);
+        p.majfltRate = std::max(0.0, (double)(p.stat.majflt - track.majflt) / elapsed);
+        p.majfltSpike = p.majfltRate >= spikeMinimum && p.majfltRate > spikeFactor * track.majfltAverage;
+        track.majfltAverage += smoothing * (p.majfltRate - track.majfltAverage);
+    }
+    track.faultSampleTime = now;
+    track.minflt = p.stat.minflt;
+    track.majflt = p.stat.majflt;
+}
+
+/**
+ * @brief Adds an RSS sample to the process's decayed least-squares fit and derives the
+ *        growth rate, how steady it is, and when memory would run out at that rate
+ */
+void updateRssTrend(Process &p, RssTrend &trend, double now, long memAvailableKb) {
+    const double windowSeconds = 1800.0;     // Samples lose weight with this time constant
+    const double minObservedSeconds = 600.0; // Don't call a leak before seeing this much
+    const double minFit = 0.8;               // R^2: mostly steady growth, not spikes
+    const double minGrowthKbPerHour = 1024.0;
+
+    if (trend.lastTime <= 0.0) trend.origin = now;
+    double decay = trend.lastTime > 0.0 ? std::exp(-(now - trend.lastTime) / windowSeconds) : 1.0;
+    double t = now - trend.origin;
+    double y = (double)p.memRssKb;
+    trend.w = trend.w * decay + 1.0;
+    trend.t = trend.t * decay + t;
+    trend.y = trend.y * decay + y;
+    trend.tt = trend.tt * decay + t * t;
+    trend.ty = trend.ty * decay + t * y;
+    trend.yy = trend.yy * decay + y * y;
+    trend.lastTime = now;
+
+    double varT = trend.w * trend.tt - trend.t * trend.t;
+    double varY = trend.w * trend.yy - trend.y * trend.y;
+    double covTY = trend.w * trend.ty - trend.t * trend.y;
+    p.rssObservedSeconds = now - trend.origin;
+    if (varT <= 0.0) return; // Fewer than two distinct sample times
+    p.rssGrowthKbPerSec = covTY / varT;
+    p.rssGrowthFit = varY > 0.0 ? (covTY * covTY) / (varT * varY) : 0.0;
+    if (p.rssGrowthKbPerSec > 0.0) p.exhaustSeconds = (double)memAvailableKb / p.rssGrowthKbPerSec;
+    p.leakSuspect = p.rssObservedSeconds >= minObservedSeconds && p.rssGrowthFit >= minFit &&
+                    p.rssGrowthKbPerSec * 3600.0 >= minGrowthKbPerHour;
+}
+
+// --- Heavy Hitters ---
+
+// CPU-seconds and peak RSS by command and by user, since start and per minute
+const size_t heavyHitterCapacity = 64;
+const int heavyHitterWindowMinutes = 10;
+HeavyHitterSketch lifetimeByComm = {{}, heavyHitterCapacity};
+HeavyHitterSketch lifetimeByUser = {{}, heavyHitterCapacity};
+std::vector<HeavyHitterSketch> minutesByComm(heavyHitterWindowMinutes, HeavyHitterSketch{{}, heavyHitterCapacity});
+std::vector<HeavyHitterSketch> minutesByUser(heavyHitterWindowMinutes, HeavyHitterSketch{{}, heavyHitterCapacity});
+long long heavyHitterMinute = -1;   // Minute (monotonic) the current slot belongs to
+bool showWindowedConsumers = false; // 'w' in the top consumers view
+
+/**
+ * @brief Adds usage to a key's counter, replacing the smallest counter when the sketch is full
+ */
+void sketchAdd(HeavyHitterSketch &sketch, const char *key, double cpuSeconds, long rssKb, bool newProcess) {
+    size_t len = strnlen(key, sizeof(HeavyHitter().key) - 1);
+    uint32_t hash = hashKey(key, len, 0);
+    HeavyHitter *target = NULL;
+    for (auto &c : sketch.counters) {
+        if (c.hash == hash && strncmp(c.key, key, len) == 0 && c.key[len] == '\0') {
+            target = &c;
+            break;
+        }
+    }
+    if (!target) {
+        if (sketch.counters.size() < sketch.capacity) {
+            sketch.counters.push_back(HeavyHitter());
+            target = &sketch.counters.back();
+        } else {
+            target = &*std::min_element(sketch.counters.begin(), sketch.counters.end(),
+                [](const HeavyHitter &a, const HeavyHitter &b) { return a.cpuSeconds < b.cpuSeconds; });
+            // The newcomer inherits the evicted count as its possible overestimate
+            target->error = target->cpuSeconds;
+            target->peakRssKb = 0;
+            target->processes = 0;
+        }
+        memcpy(target->key, key, len);
+        target->key[len] = '\0';
+        target->hash = hash;
+        newProcess = true; // Count the process under its new key
+    }
+    target->cpuSeconds += cpuSeconds;
+    target->peakRssKb = std::max(target->peakRssKb, rssKb);
+    if (newProcess) target->processes++;
+}
+
+/**
+ * @brief Records one process's usage since the previous scan (or its exit) in every sketch
+ */
+void recordHeavyHitters(const char *name, const char *user, double cpuSeconds, long rssKb, bool newProcess,
+                        double now) {
+    long long minute = (long long)(now / 60.0);
+    // Minutes before the first one (within 10 minutes of boot) are negative; keep slots in range
+    auto slotOf = [](long long m) {
+        return (int)(((m % heavyHitterWindowMinutes) + heavyHitterWindowMinutes) % heavyHitterWindowMinutes);
+    };
+    if (minute != heavyHitterMinute) {
+        // Clear the slots of the minutes that passed (all of them after a long pause)
+        long long steps = heavyHitterMinute < 0 ? heavyHitterWindowMinutes
+                                                : std::min<long long>(minute - heavyHitterMinute, heavyHitterWindowMinutes);
+        for (long long m = minute - steps + 1; m <= minute; ++m) {
+            minutesByComm[slotOf(m)].counters.clear();
+            minutesByUser[slotOf(m)].counters.clear();
+        }
+        heavyHitterMinute = minute;
+    }
+    int slot = slotOf(minute);
+    sketchAdd(lifetimeByComm, name, cpuSeconds, rssKb, newProcess);
+    sketchAdd(lifetimeByUser, user, cpuSeconds, rssKb, newProcess);
+    sketchAdd(minutesByComm[slot], name, cpuSeconds, rssKb, newProcess);
+    sketchAdd(minutesByUser[slot], user, cpuSeconds, rssKb, newProcess);
+}
+
+/**
+ * @brief The heaviest keys of one sketch, or of the per-minute sketches summed, biggest first
+ */
+std::vector<HeavyHitter> topHeavyHitters(const HeavyHitterSketch &lifetime,
+                                         const std::vector<HeavyHitterSketch> &minutes, bool windowed) {
+    std::vector<HeavyHitter> top;
+    if (!windowed) {
+        top = lifetime.counters;
+    } else {
+        for (const auto &sketch : minutes) {
+            for (const auto &c : sketch.counters) {
+                auto it = std::find_if(top.begin(), top.end(), [&](const HeavyHitter &t) {
+                    return t.hash == c.hash && strcmp(t.key, c.key) == 0;
+                });
+                if (it == top.end()) {
+                    top.push_back(c);
+                } else {
+                    it->cpuSeconds += c.cpuSeconds;
+                    it->error += c.error;
+                    it->peakRssKb = std::max(it->peakRssKb, c.peakRssKb);
+                    it->processes += c.processes;
+                }
+            }
+        }
+    }
+    std::sort(top.begin(), top.end(), [](const HeavyHitter &a, const HeavyHitter &b) {
+        return a.cpuSeconds > b.cpuSeconds;
+    });
+    return top;
+}
+
+// --- Exited Processes ---
+
+// The most recent exits, oldest overwritten first, and per-command exit totals
+const size_t exitRingSize = 256;
+ExitedProcess exitRing[exitRingSize];
+size_t exitRingNext = 0;
+unsigned long long exitCount = 0;
+HeavyHitterSketch exitedByComm = {{}, heavyHitterCapacity};
+
+// Taskstats exit notifications (-1 if unavailable; exits are then found by the process scan)
+int exitEventSocket = -1;
+std::string exitEventStatus = "scan fallback";
+unsigned long long exitEventOverruns = 0; // Times the kernel dropped events (ENOBUFS)
+
+// Exited threads of processes no scan has seen, held until the process's last thread exits
+struct PendingExit {
+    double cpuSeconds;     // Summed over the threads that have exited so far
+    double updated;        // monotonicSeconds() of the latest record
+    bool haveLeader;       // The leader exited first; its record describes the process
+    ExitedProcess leader;
+};
+const size_t pendingExitLimit = 4096;
+const double pendingExitMaxAge = 300.0; // Older entries lost their last record (kernel drops)
+std::unordered_map<int, PendingExit> pendingExits;
+
+/**
+ * @brief Adds an exit to the ring and the per-command totals
+ */
+void recordExit(const ExitedProcess &e) {
+    exitRing[exitRingNext] = e;
+    exitRingNext = (exitRingNext + 1) % exitRingSize;
+    exitCount++;
+    sketchAdd(exitedByComm, e.name, e.cpuSeconds, e.peakRssKb, true);
+}
+
+/**
+ * @brief Subscribes to taskstats exit events for every CPU. Needs CAP_NET_ADMIN and the
+ *        initial PID and network namespaces; otherwise exits come from the process scan.
+ */
+void openExitEvents() {
+    int sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (sock < 0) {
+        exitEventStatus = "scan fallback: no netlink";
+        return;
+    }
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    struct timeval timeout = {0, 200000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    int family = 0;
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 || (family = resolveTaskstatsFamily(sock)) == 0) {
+        close(sock);
+        exitEventStatus = "scan fallback: no taskstats in kernel";
+        return;
+    }
+    // An exec storm sends thousands of events per refresh; give them room (FORCE needs root)
+    int bufferSize = 8 << 20;
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &bufferSize, sizeof(bufferSize)) < 0) {
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+    }
+
+    char buf[256] = {0};
+    struct nlmsghdr *msg = (struct nlmsghdr *)buf;
+    msg->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    msg->nlmsg_type = family;
+    msg->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    struct genlmsghdr *genl = (struct genlmsghdr *)NLMSG_DATA(msg);
+    genl->cmd = TASKSTATS_CMD_GET;
+    genl->version = TASKSTATS_GENL_VERSION;
+    std::string cpumask = "0-" + std::to_string(std::max(0L, sysconf(_SC_NPROCESSORS_CONF) - 1));
+    addNetlinkAttr(msg, TASKSTATS_CMD_ATTR_REGISTER_CPUMASK, cpumask.c_str(), cpumask.size() + 1);
+    int error = EIO;
+    if (send(sock, buf, msg->nlmsg_len, 0) >= 0) {
+        char reply[1024];
+        ssize_t len = recv(sock, reply, sizeof(reply), 0);
+        struct nlmsghdr *ack = (struct nlmsghdr *)reply;
+        if (len > 0 && NLMSG_OK(ack, (size_t)len) && ack->nlmsg_type == NLMSG_ERROR) {
+            error = -((struct nlmsgerr *)NLMSG_DATA(ack))->error;
+        }
+    }
+    if (error != 0) {
+        close(sock);
+        exitEventStatus = (error == EPERM || error == EACCES) ? "scan fallback: exit events need CAP_NET_ADMIN"
+                                                              : "scan fallback: exit events unavailable here";
+        return;
+    }
+    fcntl(sock, F_SETFL, O_NONBLOCK);
+    exitEventSocket = sock;
+    exitEventStatus = "taskstats exit events";
+}
+
+/**
+ * @brief Seconds since a process started, from its /proc/[pid]/stat starttime
+ */
+double secondsSinceStart(long long starttime) {
+    struct timespec boot;
+    clock_gettime(CLOCK_BOOTTIME, &boot);
+    return std::max(0.0, boot.tv_sec + boot.tv_nsec / 1e9 - starttime / clockTicksPerSecond);
+}
+
+/**
+ * @brief Whether a process whose leader just exited still has other threads running:
+ *        /proc/[pid]/task has a link per live thread besides "." and the zombie leader
+ */
+bool otherThreadsRunning(int tgid) {
+    struct stat st;
+    std::string path = "/proc/" + std::to_string(tgid) + "/task";
+    return stat(path.c_str(), &st) == 0 && st.st_nlink > 3;
+}
+
+/**
+ * @brief Drops processes whose last thread's exit never arrived (events the kernel dropped)
+ */
+void prunePendingExits(double now) {
+    for (auto it = pendingExits.begin(); it != pendingExits.end();) {
+        if (now - it->second.updated > pendingExitMaxAge) {
+            it = pendingExits.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * @brief Records a process whose last thread exited. The CPU time no scan has counted
+ *        goes to the heavy hitters.
+ * @param leaderRecord e came from the leader's record rather than the last thread's
+ */
+void recordProcessExit(ExitedProcess e, double cpuSeconds, bool leaderRecord, double now) {
+    auto it = processTracks.find(e.pid);
+    e.scanned = it != processTracks.end() && !it->second.exited;
+    double counted = 0.0;
+    if (e.scanned) {
+        ProcessTrack &track = it->second;
+        if (!leaderRecord) {
+            // The last thread's record describes the thread; the scan knew the process
+            snprintf(e.name, sizeof(e.name), "%.15s", track.name.c_str());
+            e.ppid = track.ppid;
+            e.lifetime = secondsSinceStart(track.starttime);
+        }
+        counted = (double)(track.utime + track.stime) / clockTicksPerSecond;
+        e.cpuSeconds = std::max(cpuSeconds, counted);
+        // Zombies stay in /proc until reaped: make a later scan see no new CPU time
+        track.utime += (long long)((e.cpuSeconds - counted) * clockTicksPerSecond);
+        track.exited = true;
+    } else {
+        e.cpuSeconds = cpuSeconds;
+    }
+    recordHeavyHitters(e.name, e.user, e.cpuSeconds - counted, e.peakRssKb, !e.scanned, now);
+    recordExit(e);
+}
+
+/**
+ * @brief Accounts one task's exit record. Records before the process's last thread exits
+ *        are held in pendingExits: a scanned process's dead threads are already in its
+ *        /proc/[pid]/stat, so only its leader's record is kept.
+ * @param groupDead The record carries the group aggregate sent with a multithreaded
+ *        process's last thread
+ */
+void handleExitRecord(const struct taskstats &ts, bool groupDead, double now) {
+    int tgid = ts.ac_tgid ? (int)ts.ac_tgid : (int)ts.ac_pid;
+    bool leaderRecord = (int)ts.ac_pid == tgid;
+    double cpuSeconds = (double)(ts.ac_utime + ts.ac_stime) / 1e6;
+
+    ExitedProcess e = {};
+    e.pid = tgid;
+    e.ppid = ts.ac_ppid;
+    snprintf(e.name, sizeof(e.name), "%.15s", ts.ac_comm);
+    auto user = usernameCache.find(ts.ac_uid);
+    snprintf(e.user, sizeof(e.user), "%s",
+             user != usernameCache.end() ? user->second.c_str() : std::to_string(ts.ac_uid).c_str());
+    e.peakRssKb = (long)ts.hiwater_rss;
+    e.lifetime = (double)ts.ac_etime / 1e6;
+    e.exitCode = (int)ts.ac_exitcode;
+    e.exitTime = now;
+
+    auto pending = pendingExits.find(tgid);
+    if (!groupDead) {
+        auto track = processTracks.find(tgid);
+        bool scanned = track != processTracks.end() && !track->second.exited;
+        if (scanned && !leaderRecord) return;
+        if (pending == pendingExits.end()) {
+            if (pendingExits.size() >= pendingExitLimit) prunePendingExits(now);
+            if (pendingExits.size() >= pendingExitLimit) return;
+            pending = pendingExits.emplace(tgid, PendingExit()).first;
+        }
+        pending->second.cpuSeconds += cpuSeconds;
+        pending->second.updated = now;
+        if (leaderRecord) {
+            pending->second.haveLeader = true;
+            pending->second.leader = e;
+        }
+        return;
+    }
+
+    if (pending != pendingExits.end()) {
+        cpuSeconds += pending->second.cpuSeconds;
+        if (pending->second.haveLeader) {
+            // Name the process after its leader, not the thread that happened to exit last
+            const ExitedProcess &leader = pending->second.leader;
+            snprintf(e.name, sizeof(e.name), "%s", leader.name);
+            e.ppid = leader.ppid;
+            e.lifetime = std::max(e.lifetime, leader.lifetime + (now - leader.exitTime));
+            leaderRecord = true;
+        }
+        pendingExits.erase(pending);
+    }
+    recordProcessExit(e, cpuSeconds, leaderRecord, now);
+}
+
+/**
+ * @brief Reads every queued exit event without blocking
+ */
+void drainExitEvents() {
+    static char buf[64 * 1024];
+    static double lastPrune = 0.0;
+    double now = monotonicSeconds();
+    if (now - lastPrune > pendingExitMaxAge / 10) {
+        prunePendingExits(now);
+        lastPrune = now;
+    }
+    std::vector<int> leaderExits;
+    for (;;) {
+        ssize_t len = recv(exitEventSocket, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS) { // The kernel dropped events; keep reading the rest
+                exitEventOverruns++;
+                continue;
+            }
+            break;
+        }
+        for (struct nlmsghdr *msg = (struct nlmsghdr *)buf; NLMSG_OK(msg, (size_t)len); msg = NLMSG_NEXT(msg, len)) {
+            if (msg->nlmsg_type == NLMSG_ERROR || msg->nlmsg_type == NLMSG_DONE) continue;
+            char *attrs = (char *)NLMSG_DATA(msg) + GENL_HDRLEN;
+            int attrsLen = msg->nlmsg_len - NLMSG_LENGTH(GENL_HDRLEN);
+            // One record per exiting thread; only the group aggregate's presence is used
+            struct nlattr *aggr = findNetlinkAttr(attrs, attrsLen, TASKSTATS_TYPE_AGGR_PID);
+            if (!aggr) continue;
+            struct nlattr *data = findNetlinkAttr((char *)aggr + NLA_HDRLEN, aggr->nla_len - NLA_HDRLEN,
+                                                  TASKSTATS_TYPE_STATS);
+            if (!data) continue;
+            struct taskstats ts = {};
+            memcpy(&ts, (char *)data + NLA_HDRLEN,
+                   std::min((size_t)(data->nla_len - NLA_HDRLEN), sizeof(struct taskstats)));
+            bool groupDead = findNetlinkAttr(attrs, attrsLen, TASKSTATS_TYPE_AGGR_TGID) != NULL;
+            if (!groupDead && (!ts.ac_tgid || ts.ac_pid == ts.ac_tgid)) leaderExits.push_back(ts.ac_pid);
+            handleExitRecord(ts, groupDead, now);
+        }
+    }
+
+    // A single-threaded process sends no group aggregate, and neither does a leader that
+    // exits before its threads. Threads post their record before leaving /proc/[pid]/task,
+    // so once it shows none running, any aggregate still to come has been read above.
+    for (int tgid : leaderExits) {
+        auto pending = pendingExits.find(tgid);
+        if (pending == pendingExits.end() || !pending->second.haveLeader || otherThreadsRunning(tgid)) continue;
+        ExitedProcess e = pending->second.leader;
+        double cpuSeconds = pending->second.cpuSeconds;
+        pendingExits.erase(pending);
+        recordProcessExit(e, cpuSeconds, true, now);
+    }
+}
+
+/**
+ * @brief Without exit events, records a process that disappeared between two scans
+ *        from what the last scan saw
+ */
+void recordScannedExit(int pid, const ProcessTrack &track, double now) {
+    ExitedProcess e = {};
+    e.pid = pid;
+    e.ppid = track.ppid;
+    snprintf(e.name, sizeof(e.name), "%s", track.name.c_str());
+    snprintf(e.user, sizeof(e.user), "%s", track.user.c_str());
+    e.cpuSeconds = (double)(track.utime + track.stime) / clockTicksPerSecond;
+    e.peakRssKb = track.peakRssKb;
+    e.lifetime = secondsSinceStart(track.starttime);
+    e.exitCode = -1;
+    e.exitTime = now;
+    e.scanned = true;
+    recordExit(e);
+}
+
+/**
+ * @brief Scores a sample against an exponentially weighted baseline, then folds it in
+ * @param floor Smallest standard deviation assumed, so a perfectly flat history
+ *        does not turn a tiny change into a huge score
+ * @return |x - mean| in standard deviations, measured before the update
+ */
+double updateBaseline(EwmaBaseline &b, double x, double floor, bool first) {
+    const double alpha = 0.05; // About 40 samples (80 s at the default refresh) of memory
+    if (first) {
+        b.mean = (float)x;
+        b.variance = 0.0f;
+        return 0.0;
+    }
+    double diff = x - b.mean;
+    double score = std::fabs(diff) / std::sqrt((double)b.variance + floor * floor);
+    double increment = alpha * diff;
+    b.mean = (float)(b.mean + increment);
+    b.variance = (float)((1.0 - alpha) * (b.variance + diff * increment));
+    return score;
+}
+
+/**
+ * @brief Updates the process's CPU% and RSS baselines and scores this sample against them
+ */
+void updateAnomalyScore(Process &p, ProcessTrack &track) {
+    const unsigned short warmupSamples = 15;
+    bool first = track.baselineSamples == 0;
+    p.cpuScore = updateBaseline(track.cpuBaseline, p.cpuPercent, 1.0, first);
+    double rssFloor = std::max(1024.0, 0.01 * track.rssBaseline.mean); // 1 MB or 1%
+    p.rssScore = updateBaseline(track.rssBaseline, (double)p.memRssKb, rssFloor, first);
+    if (track.baselineSamples < 0xFFFF) track.baselineSamples++;
+
+    p.cpuBaseline = track.cpuBaseline.mean;
+    p.cpuDeviation = std::sqrt((double)track.cpuBaseline.variance);
+    p.rssBaseline = track.rssBaseline.mean;
+    p.rssDeviation = std::sqrt((double)track.rssBaseline.variance);
+    if (track.baselineSamples < warmupSamples) {
+        p.cpuScore = p.rssScore = 0.0;
+    }
+    p.anomalyScore = std::max(p.cpuScore, p.rssScore);
+}
+
+// Time constants of the smoothed CPU% columns, in seconds
+const double cpuAverageWindows[3] = {1.0, 10.0, 60.0};
+
+/**
+ * @brief Decays the smoothed CPU% toward this sample. The weight depends on the time since
+ *        the previous update, so refreshes triggered early by events don't skew the windows.
+ */
+void updateCpuAverages(Process &p, ProcessTrack &track, double now) {
+    double elapsed = now - track.cpuAverageTime;
+    for (int i = 0; i < 3; ++i) {
+        if (track.cpuAverageTime <= 0.0) {
+            track.cpuAverage[i] = (float)p.cpuPercent; // Start from the first real sample
+        } else if (elapsed > 0.0) {
+            double weight = 1.0 - std::exp(-elapsed / cpuAverageWindows[i]);
+            track.cpuAverage[i] += (float)(weight * (p.cpuPercent - track.cpuAverage[i]));
+        }
+        p.cpuAverage[i] = track.cpuAverage[i];
+    }
+    track.cpuAverageTime = now;
+}
+
+// --- Percentile Histograms ---
+
+// Percentiles cover the last histogramWindowSeconds / 2 to histogramWindowSeconds
+double histogramWindowSeconds = 600.0;
+bool batchMode = false; // Headless: print snapshots instead of drawing them
+
+// Group totals per group label, for the current grouping
+struct GroupHistory {
+    WindowedHistogram cpu;
+    WindowedHistogram rss;
+    long long lastHalf;    // Forgotten once a whole window has passed without the group
+};
+std::unordered_map<std::string, GroupHistory> groupHistory;
+GroupBy groupHistoryBy = GROUP_BY_SERVICE;
+
+uint16_t histogramBucket(uint64_t value) {
+    if (value < 16) return (uint16_t)value;
+    int exponent = 63 - __builtin_clzll(value); // >= 4
+    return (uint16_t)(16 + (exponent - 4) * 8 + ((value >> (exponent - 3)) & 7));
+}
+
+/**
+ * @brief The middle of a bucket's value range
+ */
+double histogramBucketValue(uint16_t bucket) {
+    if (bucket < 16) return bucket;
+    int exponent = (bucket - 16) / 8 + 4;
+    double width = std::ldexp(1.0, exponent - 3);
+    return (8 + (bucket - 16) % 8) * width + (width - 1) / 2;
+}
+
+/**
+ * @brief Adds count samples to one bucket (counts saturate rather than wrap)
+ */
+void histogramAddBucket(LogHistogram &h, uint16_t bucket, uint32_t count) {
+    auto it = std::lower_bound(h.buckets.begin(), h.buckets.end(), std::make_pair(bucket, (uint16_t)0));
+    if (it == h.buckets.end() || it->first != bucket) {
+        it = h.buckets.insert(it, {bucket, 0});
+    }
+    // Count only what the bucket absorbed, so percentile ranks stay within the buckets' total
+    uint32_t added = std::min<uint32_t>(0xFFFF - it->second, count);
+    it->second += added;
+    h.count += added;
+}
+
+void histogramMerge(LogHistogram &into, const LogHistogram &from) {
+    for (const auto &b : from.buckets) histogramAddBucket(into, b.first, b.second);
+    into.max = std::max(into.max, from.max);
+}
+
+/**
+ * @brief Records a sample, starting a new half-window (and dropping the oldest) when one has passed
+ */
+void windowedAdd(WindowedHistogram &w, uint64_t value, double now) {
+    long long half = (long long)(now / (histogramWindowSeconds / 2));
+    if (half != w.half) {
+        if (half - w.half >= 2) w.halves[(half + 1) % 2] = LogHistogram(); // Both halves are stale
+        w.halves[half % 2] = LogHistogram();
+        w.half = half;
+    }
+    LogHistogram &h = w.halves[half % 2];
+    histogramAddBucket(h, histogramBucket(value), 1);
+    h.max = std::max(h.max, value);
+}
+
+/**
+ * @brief p50/p95/p99/max over both halves, scaled from histogram units by unit
+ */
+Percentiles windowedPercentiles(const WindowedHistogram &w, double unit) {
+    LogHistogram merged = w.halves[0];
+    histogramMerge(merged, w.halves[1]);
+    Percentiles result = {0.0, 0.0, 0.0, merged.max * unit};
+    if (merged.count == 0) return result;
+    const double quantiles[3] = {0.50, 0.95, 0.99};
+    double *targets[3] = {&result.p50, &result.p95, &result.p99};
+    uint64_t seen = 0;
+    size_t q = 0;
+    for (const auto &b : merged.buckets) {
+        seen += b.second;
+        while (q < 3 && seen >= std::ceil(quantiles[q] * merged.count)) {
+            *targets[q++] = std::min(histogramBucketValue(b.first), (double)merged.max) * unit;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Percentiles are only computed while something displays or exports them
+ */
+bool percentilesActive() {
+    return batchMode || currentColumnSet == COLS_PERCENTILES;
+}
+
+/**
+ * @brief Adds this refresh's group totals to each group's history and fills in their
+ *        percentiles. Groups not seen for a whole window are forgotten.
+ */
+void recordGroupHistory(std::vector<ProcessGroup> &groups, GroupBy groupBy, double now) {
+    if (groupBy != groupHistoryBy) {
+        groupHistory.clear();
+        groupHistoryBy = groupBy;
+    }
+    long long half = (long long)(now / (histogramWindowSeconds / 2));
+    for (auto &g : groups) {
+        GroupHistory &history = groupHistory[g.key];
+        history.lastHalf = half;
+        windowedAdd(history.cpu, (uint64_t)std::llround(g.cpuPercent * 10.0), now);
+        windowedAdd(history.rss, (uint64_t)std::max(0L, g.memRssKb), now);
+        g.cpuPercentiles = windowedPercentiles(history.cpu, 0.1);
+        g.rssPercentiles = windowedPercentiles(history.rss, 1.0);
+    }
+    for (auto it = groupHistory.begin(); it != groupHistory.end();) {
+        if (half - it->second.lastHalf >= 2) {
+            it = groupHistory.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * @brief Fills in group percentiles without adding samples (for paused or filtered lists)
+ */
+void attachGroupPercentiles(std::vector<ProcessGroup> &groups) {
+    for (auto &g : groups) {
+        auto it = groupHistory.find(g.key);
+        if (it == groupHistory.end() || groupHistoryBy != currentGroupBy) continue;
+        g.cpuPercentiles = windowedPercentiles(it->second.cpu, 0.1);
+        g.rssPercentiles = windowedPercentiles(it->second.rss, 1.0);
+    }
+}
+
+/**
+ * @brief Attribution is only resolved while something displays it
+ */
+bool serviceAttributionActive() {
+    return showServiceColumn || (currentView == VIEW_GROUPS && currentGroupBy == GROUP_BY_SERVICE);
+}
+
+/**
+ * @brief Gets all running processes by scanning /proc
+ * @param totalSystemMemKb Total system memory for calculating %
+ * @param totalCpuTimeDelta Total CPU time elapsed since last check
+ * @return A vector of Process structs
+ */
+std::vector<Process> getProcesses(long totalSystemMemKb, long memAvailableKb, long long totalCpuTimeDelta) {
+    std::vector<Process> processes;
+    DIR *dir;
+    struct dirent *entry;
+
+    if ((dir = opendir("/proc")) == NULL) {
+        return processes; // Cannot open /proc
+    }
+    processScanCount++;
+    double now = monotonicSeconds();
+    bool collectIo = ioCollectionActive();
+    bool collectSched = schedCollectionActive();
+    static std::string statBuf;
+
+    while ((entry = readdir(dir)) != NULL) {
+        // Check if directory name is a number (PID)
+        int pid = 0;
+        try {
+            pid = std::stoi(entry->d_name);
+        } catch (...) {
+            continue; // Not a PID
+        }
+
+        Process p = {0};
+        p.pid = pid;
+
+        // 1. Read /proc/[pid]/stat: CPU times, last CPU and the rest of the record
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+        if (readFile(path, statBuf) <= 0 || !parsePidStat(statBuf.c_str(), p.stat)) continue;
+
+        // 2. Read /proc/[pid]/status for Name, Memory
+        std::ifstream statusFile("/proc/" + std::to_string(pid) + "/status");
+        if (!statusFile.is_open()) continue;
+        
+        std::string line;
+        long long voluntaryCs = -1, involuntaryCs = -1;
+        while (std::getline(statusFile, line)) {
+            if (line.rfind("Name:", 0) == 0) {
+                p.name = line.substr(6); // Get value after "Name: "
+                p.name.erase(p.name.find_last_not_of(" \n\r\t")+1); // Trim whitespace
+            } else if (line.rfind("VmRSS:", 0) == 0) {
+                // VmRSS is the "Resident Set Size", physical memory
+                p.memRssKb = std::stol(line.substr(7));
+            } else if (line.rfind("RssAnon:", 0) == 0) {
+                p.rssAnonKb = std::stol(line.substr(8));
+            } else if (line.rfind("RssFile:", 0) == 0) {
+                p.rssFileKb = std::stol(line.substr(8));
+            } else if (line.rfind("RssShmem:", 0) == 0) {
+                p.rssShmemKb = std::stol(line.substr(9));
+            } else if (line.rfind("VmSwap:", 0) == 0) {
+                p.swapKb = std::stol(line.substr(7));
+            } else if (line.rfind("Cpus_allowed_list:", 0) == 0) {
+                size_t start = line.find_first_not_of(" \t", 18);
+                if (start != std::string::npos) p.affinity = line.substr(start);
+            } else if (line.rfind("voluntary_ctxt_switches:", 0) == 0) {
+                voluntaryCs = std::stoll(line.substr(24));
+            } else if (line.rfind("nonvoluntary_ctxt_switches:", 0) == 0) {
+                involuntaryCs = std::stoll(line.substr(27));
+            }
+        }
+        statusFile.close();
+        if (p.name.empty()) continue; // Process might have terminated
+
+        // 3. Get Username
+        p.user = getUsername(pid);
+
+        // Reset the tracked state if the PID was reused by a new process
+        ProcessTrack &track = processTracks[pid];
+        bool firstSample = track.seenScan == 0 || track.starttime != p.stat.starttime;
+        if (firstSample) {
+            track = ProcessTrack();
+            track.starttime = p.stat.starttime;
+            track.lastCpu = p.stat.processor;
+        }
+        track.seenScan = processScanCount;
+        track.name = p.name;
+        track.user = p.user;
+        track.ppid = p.stat.ppid;
+        track.peakRssKb = std::max(track.peakRssKb, p.memRssKb);
+
+        // A task that moved between refreshes migrated at least once
+        if (p.stat.processor != track.lastCpu) {
+            track.migrations++;
+            track.lastCpu = p.stat.processor;
+            p.migratedNow = true;
+        }
+        p.migrations = track.migrations;
+
+        // 4. Calculate CPU %
+        long long currentProcessTotalTime = p.stat.utime + p.stat.stime;
+        long long prevProcessTotalTime = track.utime + track.stime;
+
+        // An exit record may have raised the track past what the zombie's stat still shows
+        long long processTimeDelta = std::max(0LL, currentProcessTotalTime - prevProcessTotalTime);
+
+        // Heavy hitters: a process born since the last scan brings all its CPU time so far.
+        // The first scan only counts processes; usage before the monitor started is not counted.
+        double cpuSeconds = processScanCount > 1 ? (double)processTimeDelta / clockTicksPerSecond : 0.0;
+        recordHeavyHitters(p.name.c_str(), p.user.c_str(), cpuSeconds, p.memRssKb, firstSample, now);
+        if (totalCpuTimeDelta > 0) {
+            p.cpuPercent = 100.0 * (double)processTimeDelta / (double)totalCpuTimeDelta;
+        } else {
+            p.cpuPercent = 0.0;
+        }
+        
+        // 5. Calculate Memory %
+        if (totalSystemMemKb > 0) {
+            p.memPercent = 100.0 * (double)p.memRssKb / (double)totalSystemMemKb;
+        } else {
+            p.memPercent = 0.0;
+        }
+
+        // 6. Service / container attribution, resolved once per process
+        if (serviceAttributionActive()) {
+            if (!track.serviceResolved) {
+                track.service = getProcessService(pid);
+                track.serviceResolved = true;
+            }
+            p.service = track.service;
+        }
+
+        // 7. I/O rates, only while displayed or sorted on
+        if (collectIo) {
+            readProcessIo(pid, p, track, now);
+        }
+
+        // 8. Scheduler latency: context switches come free with status, schedstat is one more read
+        if (voluntaryCs >= 0 && involuntaryCs >= 0) {
+            double elapsed = now - track.csSampleTime;
+            if (track.csSampleTime > 0.0 && elapsed > 0.0) {
+                p.voluntaryCsRate = std::max(0.0, (double)(voluntaryCs - track.voluntaryCs) / elapsed);
+                p.involuntaryCsRate = std::max(0.0, (double)(involuntaryCs - track.involuntaryCs) / elapsed);
+            }
+            track.csSampleTime = now;
+            track.voluntaryCs = voluntaryCs;
+            track.involuntaryCs = involuntaryCs;
+        }
+        if (collectSched) {
+            readProcessSchedLatency(pid, p, track);
+        }
+
+        // 9. Page fault rates, straight from the stat record
+        updateFaultRates(p, track, now);
+
+        // 10. RSS growth trend, for the leak detector
+        updateRssTrend(p, track.rssTrend, now, memAvailableKb);
+
+        // 11. Deviation from this process's own CPU and RSS baseline (the first CPU% of a
+        //     process has no previous sample to diff against, so it would poison the baseline)
+        if (!firstSample) {
+            updateAnomalyScore(p, track);
+        }
+
+        // 12. CPU% smoothed over several windows, to sort by sustained rather than momentary use,
+        //     and its (and RSS's) distribution over the histogram window
+        if (!firstSample) {
+            updateCpuAverages(p, track, now);
+            windowedAdd(track.cpuHistory, (uint64_t)std::llround(std::max(0.0, p.cpuPercent) * 10.0), now);
+        }
+        windowedAdd(track.rssHistory, (uint64_t)std::max(0L, p.memRssKb), now);
+        if (percentilesActive()) {
+            p.cpuPercentiles = windowedPercentiles(track.cpuHistory, 0.1);
+            p.rssPercentiles = windowedPercentiles(track.rssHistory, 1.0);
+        }
+
+        track.utime = p.stat.utime;
+        track.stime = p.stat.stime;
+        processes.push_back(p);
+    }
+    closedir(dir);
+
+    // 13. Delay accounting for the I/O view or a delay sort, batched over the whole snapshot
+    if (delayCollectionActive()) {
+        collectDelayAccounting(processes, now);
+    }
+
+    // Forget processes that have exited. Their exit records are read first: a process reaped
+    // since the last drain must still find its track, or its CPU time is counted again.
+    if (exitEventSocket >= 0) drainExitEvents();
+    for (auto it = processTracks.begin(); it != processTracks.end();) {
+        if (it->second.seenScan != processScanCount) {
+            if (exitEventSocket < 0 && !it->second.exited) recordScannedExit(it->first, it->second, now);
+            it = processTracks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return processes;
+}
+
+// --- Pressure Stall Information ---
+
+PsiResource psiResources[] = {{"cpu"}, {"memory"}, {"io"}};
+double prevPsiSampleTime = 0.0;
+
+// Kernel PSI triggers: each fd becomes POLLPRI-readable when its stall threshold is crossed
+std::vector<int> psiTriggerFds;
+std::vector<const char *> psiTriggerNames;
+const char *lastPsiEvent = NULL;
+double lastPsiEventTime = 0.0;
+int psiEventCount = 0;
+
+/**
+ * @brief Parses one "some avg10=.. avg60=.. avg300=.. total=.." line
+ */
+bool parsePsiLine(const char *text, const char *kind, PsiLine &line) {
+    const char *p = strstr(text, kind);
+    if (!p) return false;
+    return sscanf(p + strlen(kind), " avg10=%lf avg60=%lf avg300=%lf total=%llu",
+                  &line.avg10, &line.avg60, &line.avg300, &line.total) == 4;
+}
+
+/**
+ * @brief Reads the "some" avg10 of a pressure file (system-wide or per-cgroup)
+ * @return The percentage, or -1 if the file does not exist
+ */
+double readPressureAvg10(const std::string &path) {
+    static std::string buf;
+    PsiLine line = {};
+    if (readFile(path.c_str(), buf) <= 0 || !parsePsiLine(buf.c_str(), "some", line)) return -1.0;
+    return line.avg10;
+}
+
+/**
+ * @brief Reads /proc/pressure/{cpu,memory,io} and the stall rate since the previous read
+ */
+void getPressure() {
+    static std::string buf;
+    double now = monotonicSeconds();
+    double elapsed = now - prevPsiSampleTime;
+    for (auto &r : psiResources) {
+        PsiLine prevSome = r.some, prevFull = r.full;
+        std::string path = std::string("/proc/pressure/") + r.name;
+        r.available = readFile(path.c_str(), buf) > 0 && parsePsiLine(buf.c_str(), "some", r.some);
+        if (!r.available) continue;
+        // cpu has no "full" line on older kernels
+        if (!parsePsiLine(buf.c_str(), "full", r.full)) r.full = PsiLine();
+        if (prevPsiSampleTime > 0.0 && elapsed > 0.0) {
+            r.some.stallRate = (double)(r.some.total - prevSome.total) / 1000.0 / elapsed;
+            r.full.stallRate = (double)(r.full.total - prevFull.total) / 1000.0 / elapsed;
+        }
+    }
+    prevPsiSampleTime = now;
+}
+
+/**
+ * @brief Registers a kernel PSI trigger per resource: wake us when "some" stall
+ *        time exceeds 10% of a window. Unprivileged users may only use windows
+ *        that are multiples of 2s, so a 1s window falls back to 2s.
+ */
+void registerPsiTriggers() {
+    static const char *triggers[] = {"some 100000 1000000", "some 200000 2000000"};
+    for (auto &r : psiResources) {
+        std::string path = std::string("/proc/pressure/") + r.name;
+        for (const char *trigger : triggers) {
+            int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+            if (fd < 0) break;
+            if (write(fd, trigger, strlen(trigger) + 1) >= 0) {
+                psiTriggerFds.push_back(fd);
+                psiTriggerNames.push_back(r.name);
+                break;
+            }
+            close(fd);
+        }
+    }
+}
+
+/**
+ * @brief Waits for a key press, a PSI trigger, a background result, or the refresh
+ *        interval, whichever comes first. Exit events are accounted while waiting
+ *        but don't end the wait, so an exec storm doesn't turn into a redraw storm.
+ * @return The key pressed, or ERR if woken by an event or the timeout
+ */
+int waitForEvent(int timeoutMs) {
+    int ch = getch(); // ncurses may already hold buffered input
+    if (ch != ERR) return ch;
+
+    const size_t firstPsiFd = 3;
+    std::vector<struct pollfd> fds;
+    fds.push_back({STDIN_FILENO, POLLIN, 0});
+    fds.push_back({workerWakePipe[0], POLLIN, 0}); // Ignored by poll() while -1
+    fds.push_back({exitEventSocket, POLLIN, 0});
+    for (int fd : psiTriggerFds) {
+        fds.push_back({fd, POLLPRI, 0});
+    }
+    double deadline = monotonicSeconds() + timeoutMs / 1000.0;
+    for (;;) {
+        int remainingMs = std::max(0, (int)std::ceil((deadline - monotonicSeconds()) * 1000.0));
+        if (poll(fds.data(), fds.size(), remainingMs) <= 0) return getch(); // Timeout or signal (resize)
+        if (!(fds[2].revents & POLLIN)) break;
+        drainExitEvents();
+        bool woken = false;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            if (i != 2 && fds[i].revents) woken = true;
+        }
+        if (woken) break;
+    }
+
+    if (fds[1].revents & POLLIN) {
+        char drain[64];
+        while (read(workerWakePipe[0], drain, sizeof(drain)) > 0) {}
+    }
+    for (size_t i = firstPsiFd; i < fds.size(); ++i) {
+        if (fds[i].revents & POLLPRI) {
+            lastPsiEvent = psiTriggerNames[i - firstPsiFd];
+            lastPsiEventTime = monotonicSeconds();
+            psiEventCount++;
+        }
+        if (fds[i].revents & (POLLERR | POLLNVAL)) {
+            // The trigger went away; stop polling it
+            close(psiTriggerFds[i - firstPsiFd]);
+            psiTriggerFds[i - firstPsiFd] = -1;
+        }
+    }
+    for (size_t i = psiTriggerFds.size(); i-- > 0;) {
+        if (psiTriggerFds[i] < 0) {
+            psiTriggerFds.erase(psiTriggerFds.begin() + i);
+            psiTriggerNames.erase(psiTriggerNames.begin() + i);
+        }
+    }
+    return getch();
+}
+
+// --- cgroup v2 Hierarchy ---
+
+/**
+ * @brief Finds where the cgroup2 filesystem is mounted (pure v2 or hybrid layout)
+ * @return The mount point, or an empty string if cgroup v2 is not mounted
+ */
+std::string findCgroupMount() {
+    std::ifstream file("/proc/self/mounts");
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string device, mountPoint, fsType;
+        ss >> device >> mountPoint >> fsType;
+        if (fsType == "cgroup2") {
+            return mountPoint;
+        }
+    }
+    return "";
+}
+
+/**
+ * @brief Reads cpu.stat, memory.current, memory.max and io.stat for one cgroup
+ *        and computes rates against the previous walk
+ */
+void readCgroupStats(Cgroup &cg, double elapsed, long numCpus) {
+    static std::string buf;
+    std::string dir = cgroupMount + (cg.path == "/" ? "" : cg.path);
+
+    cg.cpuUsageUsec = 0;
+    if (readFile((dir + "/cpu.stat").c_str(), buf) > 0) {
+        const char *p = strstr(buf.c_str(), "usage_usec ");
+        if (p) cg.cpuUsageUsec = strtoll(p + 11, NULL, 10);
+    }
+
+    cg.memCurrent = -1;
+    if (readFile((dir + "/memory.current").c_str(), buf) > 0) {
+        cg.memCurrent = strtoll(buf.c_str(), NULL, 10);
+    }
+
+    cg.memMax = -1;
+    if (readFile((dir + "/memory.max").c_str(), buf) > 0 && buf[0] != 'm') {
+        cg.memMax = strtoll(buf.c_str(), NULL, 10);
+    }
+
+    // io.stat has one line per device: "8:0 rbytes=... wbytes=... rios=... ..."
+    cg.ioReadBytes = 0;
+    cg.ioWriteBytes = 0;
+    if (readFile((dir + "/io.stat").c_str(), buf) > 0) {
+        for (const char *p = buf.c_str(); (p = strstr(p, "bytes=")) != NULL; p += 6) {
+            long long value = strtoll(p + 6, NULL, 10);
+            if (p[-1] == 'r') cg.ioReadBytes += value;
+            else if (p[-1] == 'w') cg.ioWriteBytes += value;
+        }
+    }
+
+    cg.cpuPressure = readPressureAvg10(dir + "/cpu.pressure");
+    cg.memPressure = readPressureAvg10(dir + "/memory.pressure");
+    cg.ioPressure = readPressureAvg10(dir + "/io.pressure");
+
+    cg.cpuPercent = 0.0;
+    cg.ioReadRate = 0.0;
+    cg.ioWriteRate = 0.0;
+    auto it = prevCgroups.find(cg.path);
+    if (it != prevCgroups.end() && elapsed > 0.0) {
+        const Cgroup &prev = it->second;
+        // Normalised to all CPUs, like the per-process CPU%
+        cg.cpuPercent = 100.0 * (double)(cg.cpuUsageUsec - prev.cpuUsageUsec) / (elapsed * 1e6 * numCpus);
+        cg.ioReadRate = (double)(cg.ioReadBytes - prev.ioReadBytes) / elapsed;
+        cg.ioWriteRate = (double)(cg.ioWriteBytes - prev.ioWriteBytes) / elapsed;
+        if (cg.cpuPercent < 0.0) cg.cpuPercent = 0.0;
+        if (cg.ioReadRate < 0.0) cg.ioReadRate = 0.0;
+        if (cg.ioWriteRate < 0.0) cg.ioWriteRate = 0.0;
+    }
+}
+
+/**
+ * @brief Lists the names of the child cgroups (subdirectories) of a cgroup
+ */
+std::vector<std::string> listChildCgroups(const std::string &path) {
+    std::vector<std::string> children;
+    std::string dir = cgroupMount + (path == "/" ? "" : path);
+    DIR *d = opendir(dir.c_str());
+    if (d == NULL) return children;
+
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_type == DT_DIR && entry->d_name[0] != '.') {
+            children.push_back(entry->d_name);
+        }
+    }
+    closedir(d);
+    return children;
+}
+
+bool compareCgroups(const Cgroup &a, const Cgroup &b) {
+    if (currentSortMode == BY_CPU && a.cpuPercent != b.cpuPercent) {
+        return a.cpuPercent > b.cpuPercent;
+    }
+    if (currentSortMode == BY_MEM && a.memCurrent != b.memCurrent) {
+        return a.memCurrent > b.memCurrent;
+    }
+    return a.name < b.name;
+}
+
+/**
+ * @brief Appends the children of a cgroup to the tree in display order,
+ *        descending only into subtrees that are not collapsed
+ */
+void walkCgroupChildren(const Cgroup &parent, std::vector<Cgroup> &tree, double elapsed, long numCpus) {
+    std::vector<Cgroup> children;
+    for (const auto &name : listChildCgroups(parent.path)) {
+        Cgroup cg = {};
+        cg.path = (parent.path == "/" ? "" : parent.path) + "/" + name;
+        cg.name = name;
+        cg.depth = parent.depth + 1;
+        readCgroupStats(cg, elapsed, numCpus);
+        children.push_back(cg);
+    }
+    std::sort(children.begin(), children.end(), compareCgroups);
+
+    for (auto &cg : children) {
+        tree.push_back(cg);
+        size_t index = tree.size() - 1;
+        if (collapsedCgroups.count(cg.path)) {
+            tree[index].hasChildren = !listChildCgroups(cg.path).empty();
+        } else {
+            size_t before = tree.size();
+            walkCgroupChildren(cg, tree, elapsed, numCpus);
+            tree[index].hasChildren = tree.size() > before;
+        }
+    }
+}
+
+/**
+ * @brief Walks the cgroup v2 hierarchy, reading each cgroup's own accounting files.
+ *        The cost is O(cgroups), independent of the number of processes.
+ * @return The visible (non-collapsed) cgroups in tree order
+ */
+std::vector<Cgroup> getCgroups() {
+    std::vector<Cgroup> tree;
+    if (cgroupMount.empty()) {
+        cgroupMount = findCgroupMount();
+        if (cgroupMount.empty()) return tree; // cgroup v2 not mounted
+    }
+
+    double now = monotonicSeconds();
+    double elapsed = (prevCgroupSampleTime > 0.0) ? now - prevCgroupSampleTime : 0.0;
+    long numCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (numCpus < 1) numCpus = 1;
+
+    Cgroup root = {};
+    root.path = "/";
+    root.name = "/";
+    root.depth = 0;
+    readCgroupStats(root, elapsed, numCpus);
+    tree.push_back(root);
+    if (!collapsedCgroups.count("/")) {
+        walkCgroupChildren(root, tree, elapsed, numCpus);
+        tree[0].hasChildren = tree.size() > 1;
+    } else {
+        tree[0].hasChildren = !listChildCgroups("/").empty();
+    }
+
+    // Remember counters for the next rates; collapsed subtrees restart from zero
+    prevCgroups.clear();
+    for (const auto &cg : tree) {
+        prevCgroups[cg.path] = cg;
+    }
+    prevCgroupSampleTime = now;
+    return tree;
+}
+
+// --- Block Devices ---
+
+// Double-buffered /proc/diskstats samples (capacity is reused across refreshes)
+std::vector<DiskStat> diskStats;
+std::vector<DiskStat> prevDiskStats;
+double prevDiskSampleTime = 0.0;
+std::unordered_map<unsigned, int> diskKindCache; // (major << 20 | minor) -> DiskKind
+
+/**
+ * @brief Classifies a block device once: whole disk, partition, or a virtual layer
+ *        (device-mapper, md RAID, loop, ram, zram) stacked on other disks
+ */
+int classifyDisk(const DiskStat &d) {
+    unsigned key = (d.major << 20) | d.minor;
+    auto it = diskKindCache.find(key);
+    if (it != diskKindCache.end()) return it->second;
+
+    static const char *virtualPrefixes[] = {"dm-", "md", "loop", "ram", "zram", "nbd"};
+    int kind = DISK_WHOLE;
+    for (const char *prefix : virtualPrefixes) {
+        if (strncmp(d.name, prefix, strlen(prefix)) == 0) kind = DISK_VIRTUAL;
+    }
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/dev/block/%u:%u/partition", d.major, d.minor);
+    if (access(path, F_OK) == 0) kind = DISK_PARTITION;
+
+    diskKindCache[key] = kind;
+    return kind;
+}
+
+/**
+ * @brief Reads /proc/diskstats into diskStats and computes per-device rates.
+ *        The parse is a single pass over one read() buffer with no allocation
+ *        once the vectors have grown to the number of devices.
+ */
+void getDiskStats() {
+    static std::string buf;
+    double now = monotonicSeconds();
+    std::swap(diskStats, prevDiskStats);
+    diskStats.clear();
+    if (readFile("/proc/diskstats", buf) <= 0) return;
+
+    double elapsed = now - prevDiskSampleTime;
+    const char *p = buf.c_str();
+    while (*p) {
+        DiskStat d;
+        d.major = (unsigned)parseNumber(p);
+        d.minor = (unsigned)parseNumber(p);
+        while (*p == ' ') ++p;
+        size_t len = 0;
+        while (*p && *p != ' ' && *p != '\n') {
+            if (len + 1 < sizeof(d.name)) d.name[len++] = *p;
+            ++p;
+        }
+        d.name[len] = '\0';
+        // (4) reads (5) merged (6) sectors (7) ms, (8)-(11) the same for writes,
+        // (12) in flight (13) ms doing I/O; discard/flush fields are ignored
+        d.reads = parseNumber(p);
+        parseNumber(p);
+        d.readSectors = parseNumber(p);
+        d.readMs = parseNumber(p);
+        d.writes = parseNumber(p);
+        parseNumber(p);
+        d.writeSectors = parseNumber(p);
+        d.writeMs = parseNumber(p);
+        parseNumber(p);
+        d.ioMs = parseNumber(p);
+        while (*p && *p != '\n') ++p;
+        if (*p == '\n') ++p;
+        if (len == 0) continue;
+
+        d.kind = classifyDisk(d);
+        d.readIops = d.writeIops = d.readBps = d.writeBps = d.awaitMs = d.utilPercent = 0.0;
+
+        // diskstats keeps a stable order, so the previous sample is usually at the same index
+        const DiskStat *prev = NULL;
+        size_t index = diskStats.size();
+        if (index < prevDiskStats.size() && prevDiskStats[index].major == d.major &&
+            prevDiskStats[index].minor == d.minor) {
+            prev = &prevDiskStats[index];
+        } else {
+            for (const auto &candidate : prevDiskStats) {
+                if (candidate.major == d.major && candidate.minor == d.minor) prev = &candidate;
+            }
+        }
+        if (prev && elapsed > 0.0 && d.reads >= prev->reads && d.writes >= prev->writes) {
+            unsigned long long ios = (d.reads - prev->reads) + (d.writes - prev->writes);
+            d.readIops = (double)(d.reads - prev->reads) / elapsed;
+            d.writeIops = (double)(d.writes - prev->writes) / elapsed;
+            d.readBps = (double)(d.readSectors - prev->readSectors) * 512.0 / elapsed;
+            d.writeBps = (double)(d.writeSectors - prev->writeSectors) * 512.0 / elapsed;
+            if (ios > 0) {
+                d.awaitMs = (double)((d.readMs - prev->readMs) + (d.writeMs - prev->writeMs)) / (double)ios;
+            }
+            d.utilPercent = std::min(100.0, (double)(d.ioMs - prev->ioMs) / (elapsed * 10.0));
+        }
+        diskStats.push_back(d);
+    }
+    prevDiskSampleTime = now;
+
+    // Forget devices that went away (loop and device-mapper numbers come and go)
+    if (diskKindCache.size() > diskStats.size()) {
+        std::unordered_set<unsigned> present;
+        for (const auto &d : diskStats) present.insert((d.major << 20) | d.minor);
+        for (auto it = diskKindCache.begin(); it != diskKindCache.end();) {
+            it = present.count(it->first) ? std::next(it) : diskKindCache.erase(it);
+        }
+    }
+}
+
+// --- Network Interfaces ---
+
+// Double-buffered /proc/net/dev samples (capacity is reused across refreshes)
+std::vector<NetStat> netStats;
+std::vector<NetStat> prevNetStats;
+double prevNetSampleTime = 0.0;
+std::unordered_map<std::string, bool> netVirtualCache;      // Interface name -> is virtual
+std::unordered_map<std::string_view, size_t> prevNetIndex; // Used only when the order changed
+
+/**
+ * @brief Length of the well-known virtual interface prefix of a name ("veth", "cali", ...)
+ * @return 0 if the name has no known prefix
+ */
+size_t virtualInterfacePrefix(const char *name) {
+    static const char *virtualPrefixes[] = {"lo", "veth", "docker", "br-", "virbr", "cni", "flannel",
+                                            "cali", "vxlan", "tun", "tap", "kube-", "cilium", "lxc"};
+    for (const char *prefix : virtualPrefixes) {
+        size_t len = strlen(prefix);
+        if (strncmp(name, prefix, len) == 0) return len;
+    }
+    return 0;
+}
+
+/**
+ * @brief Decides once per interface name whether it is virtual. Common container
+ *        prefixes are matched by name; anything else is checked in sysfs.
+ */
+bool isVirtualInterface(const char *name) {
+    if (virtualInterfacePrefix(name) > 0) return true;
+    auto it = netVirtualCache.find(name);
+    if (it != netVirtualCache.end()) return it->second;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/virtual/net/%s", name);
+    bool isVirtual = access(path, F_OK) == 0;
+    netVirtualCache[name] = isVirtual;
+    return isVirtual;
+}
+
+/**
+ * @brief Reads /proc/net/dev and computes per-interface rates. Numbers are parsed
+ *        in place from the read() buffer; nothing is copied but the name.
+ */
+void getNetStats() {
+    static std::string buf;
+    double now = monotonicSeconds();
+    std::swap(netStats, prevNetStats);
+    netStats.clear();
+    prevNetIndex.clear();
+    if (readFile("/proc/net/dev", buf) <= 0) return;
+
+    double elapsed = now - prevNetSampleTime;
+    const char *p = buf.c_str();
+    for (int header = 0; header < 2 && *p; ++header) { // Skip the two header lines
+        p = strchr(p, '\n');
+        p = p ? p + 1 : "";
+    }
+    while (*p) {
+        NetStat n;
+        while (*p == ' ') ++p;
+        size_t len = 0;
+        while (*p && *p != ':' && *p != '\n') {
+            if (len + 1 < sizeof(n.name)) n.name[len++] = *p;
+            ++p;
+        }
+        n.name[len] = '\0';
+        if (*p != ':') break;
+        ++p;
+        // Receive: bytes packets errs drop fifo frame compressed multicast, then transmit
+        n.rxBytes = parseNumber(p);
+        n.rxPackets = parseNumber(p);
+        n.rxErrors = parseNumber(p);
+        n.rxDrops = parseNumber(p);
+        for (int i = 0; i < 4; ++i) parseNumber(p);
+        n.txBytes = parseNumber(p);
+        n.txPackets = parseNumber(p);
+        n.txErrors = parseNumber(p);
+        n.txDrops = parseNumber(p);
+        while (*p && *p != '\n') ++p;
+        if (*p == '\n') ++p;
+
+        n.isVirtual = isVirtualInterface(n.name);
+        n.rxBps = n.txBps = n.rxPps = n.txPps = n.dropsPerSec = n.errorsPerSec = 0.0;
+
+        // Same index as last time unless interfaces came or went (veth churn)
+        const NetStat *prev = NULL;
+        size_t index = netStats.size();
+        if (index < prevNetStats.size() && strcmp(prevNetStats[index].name, n.name) == 0) {
+            prev = &prevNetStats[index];
+        } else {
+            if (prevNetIndex.empty()) {
+                for (size_t i = 0; i < prevNetStats.size(); ++i) {
+                    prevNetIndex[std::string_view(prevNetStats[i].name)] = i;
+                }
+            }
+            auto it = prevNetIndex.find(std::string_view(n.name));
+            if (it != prevNetIndex.end()) prev = &prevNetStats[it->second];
+        }
+        if (prev && elapsed > 0.0 && n.rxBytes >= prev->rxBytes && n.txBytes >= prev->txBytes) {
+            n.rxBps = (double)(n.rxBytes - prev->rxBytes) / elapsed;
+            n.txBps = (double)(n.txBytes - prev->txBytes) / elapsed;
+            n.rxPps = (double)(n.rxPackets - prev->rxPackets) / elapsed;
+            n.txPps = (double)(n.txPackets - prev->txPackets) / elapsed;
+            n.dropsPerSec = (double)((n.rxDrops - prev->rxDrops) + (n.txDrops - prev->txDrops)) / elapsed;
+            n.errorsPerSec = (double)((n.rxErrors - prev->rxErrors) + (n.txErrors - prev->txErrors)) / elapsed;
+        }
+        netStats.push_back(n);
+    }
+    prevNetSampleTime = now;
+
+    // Forget interfaces that went away, or veth churn grows the cache forever
+    if (netVirtualCache.size() > netStats.size()) {
+        std::unordered_set<std::string_view> present;
+        for (const auto &n : netStats) present.insert(std::string_view(n.name));
+        for (auto it = netVirtualCache.begin(); it != netVirtualCache.end();) {
+            it = present.count(it->first) ? std::next(it) : netVirtualCache.erase(it);
+        }
+    }
+}
+
+// --- Interrupts ---
+
+// Double-buffered /proc/interrupts + /proc/softirqs samples. Counts and rates are
+// row-major matrices, one row per source and one column per CPU number.
+std::vector<IrqSource> irqSources;
+std::vector<IrqSource> prevIrqSources;
+std::vector<unsigned long long> irqCounts;
+std::vector<unsigned long long> prevIrqCounts;
+std::vector<double> irqRates;
+std::vector<double> irqCpuTotals;         // Per CPU, all sources
+size_t irqCpuCount = 0;                   // Highest CPU number + 1
+size_t prevIrqCpuCount = 0;
+double prevIrqSampleTime = 0.0;
+
+/**
+ * @brief Skips the space padding between columns, 8 bytes at a time
+ */
+inline const char *skipColumnPadding(const char *p, const char *end) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    const uint64_t spaces = 0x2020202020202020ULL;
+    while (p + 8 <= end) {
+        uint64_t word;
+        memcpy(&word, p, 8);
+        uint64_t diff = word ^ spaces;
+        if (diff != 0) return p + __builtin_ctzll(diff) / 8; // First non-space byte
+        p += 8;
+    }
+#endif
+    while (p < end && *p == ' ') ++p;
+    return p;
+}
+
+/**
+ * @brief Parses one " %10u" counter column without branching on its digits: the space
+ *        padding maps to '0', and the low 8 digits are combined SWAR-style in one register.
+ * @param field Points at the separator space in front of the 10-wide number; the byte
+ *        after the number must be readable
+ * @return false if the field is not laid out that way (the caller falls back to scanning)
+ */
+inline bool parseFixedWidthCounter(const char *field, unsigned long long &value) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (field[0] != ' ' || field[10] < '0' || field[10] > '9' || (field[11] != ' ' && field[11] != '\n')) {
+        return false;
+    }
+    uint64_t word;
+    memcpy(&word, field + 3, 8);
+    uint64_t digits = (word | 0x1010101010101010ULL) ^ 0x3030303030303030ULL; // ' ' and '0'..'9' -> 0..9
+    uint64_t nonDigit = (digits & 0xF0F0F0F0F0F0F0F0ULL) |
+                        ((digits + 0x0606060606060606ULL) & 0x1010101010101010ULL);
+    int high = 0;
+    for (int i = 1; i <= 2; ++i) {
+        char c = field[i];
+        if (c != ' ' && (c < '0' || c > '9')) return false;
+        high = high * 10 + (c == ' ' ? 0 : c - '0');
+    }
+    if (nonDigit != 0) return false;
+    // The first character is the lowest byte: combine pairs, then quads, then octets
+    digits = (digits * 10 + (digits >> 8)) & 0x00FF00FF00FF00FFULL;
+    digits = (digits * 100 + (digits >> 16)) & 0x0000FFFF0000FFFFULL;
+    digits = (digits * 10000 + (digits >> 32)) & 0x00000000FFFFFFFFULL;
+    value = (unsigned long long)high * 100000000ULL + digits;
+    return true;
+#else
+    (void)field;
+    (void)value;
+    return false;
+#endif
+}
+
+/**
+ * @brief Parses one per-CPU matrix (/proc/interrupts or /proc/softirqs) into irqSources/irqCounts
+ * @param cpuIds Scratch space for the CPU number of each column
+ */
+void parseIrqMatrix(const char *p, const char *end, bool softirq, std::vector<int> &cpuIds) {
+    // Header: "           CPU0       CPU1 ..." (interrupts lists online CPUs, softirqs possible ones)
+    cpuIds.clear();
+    while (p < end && *p != '\n') {
+        p = skipColumnPadding(p, end);
+        if (p + 3 < end && strncmp(p, "CPU", 3) == 0) {
+            p += 3;
+            cpuIds.push_back((int)parseNumber(p));
+        } else if (p < end && *p != '\n') {
+            ++p;
+        }
+    }
+    if (p < end) ++p;
+    size_t oldCount = irqCpuCount;
+    for (int cpu : cpuIds) irqCpuCount = std::max(irqCpuCount, (size_t)cpu + 1);
+    if (irqCpuCount > oldCount && !irqSources.empty()) {
+        // The second file has more CPU columns: widen the rows parsed so far
+        std::vector<unsigned long long> wider(irqSources.size() * irqCpuCount, 0);
+        for (size_t r = 0; r < irqSources.size(); ++r) {
+            for (size_t c = 0; c < oldCount; ++c) wider[r * irqCpuCount + c] = irqCounts[r * oldCount + c];
+        }
+        irqCounts.swap(wider);
+    }
+
+    while (p < end) {
+        IrqSource src = {};
+        src.softirq = softirq;
+        p = skipColumnPadding(p, end);
+        size_t len = 0;
+        while (p < end && *p != ':' && *p != '\n') {
+            if (len + 1 < sizeof(src.name)) src.name[len++] = *p;
+            ++p;
+        }
+        src.name[len] = '\0';
+        if (p >= end || *p != ':') break;
+        ++p;
+
+        // Rows like "ERR:" and "MIS:" have a single system-wide count: it goes to column 0
+        size_t row = irqSources.size();
+        irqCounts.resize((row + 1) * irqCpuCount, 0);
+        unsigned long long *counts = &irqCounts[row * irqCpuCount];
+        size_t column = 0;
+        // Every column is " %10u", so the fields are at fixed offsets from the colon
+        while (column < cpuIds.size() && p + 12 <= end && parseFixedWidthCounter(p, counts[cpuIds[column]])) {
+            p += 11;
+            column++;
+        }
+        for (; column < cpuIds.size(); ++column) {
+            p = skipColumnPadding(p, end);
+            if (p >= end || *p < '0' || *p > '9') break;
+            counts[cpuIds[column]] = parseNumber(p);
+        }
+
+        // The rest of the line: chip, hwirq, trigger and device names, with spaces squeezed
+        len = 0;
+        while (p < end && *p != '\n') {
+            p = skipColumnPadding(p, end);
+            while (p < end && *p != ' ' && *p != '\n') {
+                if (len + 1 < sizeof(src.desc)) src.desc[len++] = *p;
+                ++p;
+            }
+            if (p < end && *p == ' ' && len > 0 && len + 1 < sizeof(src.desc)) src.desc[len++] = ' ';
+        }
+        while (len > 0 && src.desc[len - 1] == ' ') --len;
+        src.desc[len] = '\0';
+        if (p < end) ++p;
+        irqSources.push_back(src);
+    }
+}
+
+/**
+ * @brief Reads /proc/interrupts and /proc/softirqs and computes per-CPU rates for every source
+ */
+void getIrqStats() {
+    static std::string buf;
+    static std::vector<int> cpuIds;
+    double now = monotonicSeconds();
+    std::swap(irqSources, prevIrqSources);
+    std::swap(irqCounts, prevIrqCounts);
+    prevIrqCpuCount = irqCpuCount;
+    irqSources.clear();
+    irqCounts.clear();
+    irqCpuCount = 0;
+
+    ssize_t len = readFile("/proc/interrupts", buf);
+    if (len > 0) parseIrqMatrix(buf.c_str(), buf.c_str() + len, false, cpuIds);
+    len = readFile("/proc/softirqs", buf);
+    if (len > 0) parseIrqMatrix(buf.c_str(), buf.c_str() + len, true, cpuIds);
+    irqCounts.resize(irqSources.size() * irqCpuCount, 0);
+
+    double elapsed = now - prevIrqSampleTime;
+    bool comparable = prevIrqSampleTime > 0.0 && elapsed > 0.0 && prevIrqCpuCount == irqCpuCount;
+    irqRates.assign(irqCounts.size(), 0.0);
+    irqCpuTotals.assign(irqCpuCount, 0.0);
+    for (size_t r = 0; r < irqSources.size(); ++r) {
+        IrqSource &src = irqSources[r];
+        src.maxCpu = -1;
+        if (!comparable) continue;
+
+        // Same row as last time unless an IRQ was requested or freed
+        const IrqSource *prev = NULL;
+        size_t prevRow = r;
+        if (r < prevIrqSources.size() && prevIrqSources[r].softirq == src.softirq &&
+            strcmp(prevIrqSources[r].name, src.name) == 0) {
+            prev = &prevIrqSources[r];
+        } else {
+            for (prevRow = 0; prevRow < prevIrqSources.size(); ++prevRow) {
+                if (prevIrqSources[prevRow].softirq == src.softirq &&
+                    strcmp(prevIrqSources[prevRow].name, src.name) == 0) {
+                    prev = &prevIrqSources[prevRow];
+                    break;
+                }
+            }
+        }
+        if (!prev) continue;
+
+        const unsigned long long *cur = &irqCounts[r * irqCpuCount];
+        const unsigned long long *old = &prevIrqCounts[prevRow * irqCpuCount];
+        double *rates = &irqRates[r * irqCpuCount];
+        for (size_t c = 0; c < irqCpuCount; ++c) {
+            if (cur[c] < old[c]) continue; // Counter reset (IRQ freed and requested again)
+            rates[c] = (double)(cur[c] - old[c]) / elapsed;
+            src.totalRate += rates[c];
+            irqCpuTotals[c] += rates[c];
+            if (rates[c] > src.maxRate) {
+                src.maxRate = rates[c];
+                src.maxCpu = (int)c;
+            }
+        }
+    }
+    prevIrqSampleTime = now;
+}
+
+// --- NUMA ---
+
+std::vector<NumaNode> numaNodes;
+std::vector<NumaNode> prevNumaNodes;
+double prevNumaSampleTime = 0.0;
+
+/**
+ * @brief Reads every node's meminfo and numastat, and computes allocation rates
+ */
+void getNumaStats() {
+    static std::string buf;
+    double now = monotonicSeconds();
+    std::swap(numaNodes, prevNumaNodes);
+    numaNodes.clear();
+
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (!dir) return;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, "node", 4) != 0 || !isdigit((unsigned char)entry->d_name[4])) continue;
+        NumaNode node = {};
+        node.id = atoi(entry->d_name + 4);
+        char path[96];
+
+        // "Node 0 MemTotal:       32768000 kB"
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", node.id);
+        if (readFile(path, buf) > 0) {
+            struct { const char *key; long *value; } fields[] = {
+                {"MemTotal:", &node.memTotal}, {"MemFree:", &node.memFree},
+                {"FilePages:", &node.filePages}, {"AnonPages:", &node.anonPages},
+            };
+            for (const char *line = buf.c_str(); *line;) {
+                const char *key = strchr(line, ':');
+                if (!key) break;
+                while (key > line && key[-1] != ' ') --key;
+                for (const auto &f : fields) {
+                    size_t len = strlen(f.key);
+                    if (strncmp(key, f.key, len) == 0) {
+                        const char *p = key + len;
+                        *f.value = (long)parseNumber(p);
+                    }
+                }
+                line = strchr(line, '\n');
+                if (!line) break;
+                ++line;
+            }
+        }
+
+        // "numa_hit 123\nnuma_miss 0\n..."
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/numastat", node.id);
+        if (readFile(path, buf) > 0) {
+            struct { const char *key; unsigned long long *value; } counters[] = {
+                {"numa_hit ", &node.numaHit}, {"numa_miss ", &node.numaMiss},
+                {"numa_foreign ", &node.numaForeign}, {"local_node ", &node.localNode},
+                {"other_node ", &node.otherNode},
+            };
+            for (const auto &c : counters) {
+                const char *p = strstr(buf.c_str(), c.key);
+                if (p) {
+                    p += strlen(c.key);
+                    *c.value = parseNumber(p);
+                }
+            }
+        }
+        numaNodes.push_back(node);
+    }
+    closedir(dir);
+    std::sort(numaNodes.begin(), numaNodes.end(), [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+
+    double elapsed = now - prevNumaSampleTime;
+    if (prevNumaSampleTime > 0.0 && elapsed > 0.0) {
+        for (auto &node : numaNodes) {
+            for (const auto &prev : prevNumaNodes) {
+                if (prev.id != node.id) continue;
+                auto rate = [&](unsigned long long cur, unsigned long long old) {
+                    return cur >= old ? (double)(cur - old) / elapsed : 0.0;
+                };
+                node.hitRate = rate(node.numaHit, prev.numaHit);
+                node.missRate = rate(node.numaMiss, prev.numaMiss);
+                node.foreignRate = rate(node.numaForeign, prev.numaForeign);
+                node.otherRate = rate(node.otherNode, prev.otherNode);
+            }
+        }
+    }
+    prevNumaSampleTime = now;
+}
+
+/**
+ * @brief Sums a process's resident pages per node from /proc/[pid]/numa_maps.
+ *        Each mapping line lists "N<node>=<pages>" and then its "kernelpagesize_kB=<kB>".
+ *        Walks every mapping in the kernel, so it runs on the background reader only.
+ */
+NumaPlacement readNumaPlacement(int pid, std::string &buf) {
+    NumaPlacement placement = {};
+    placement.pid = pid;
+    placement.time = monotonicSeconds();
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/numa_maps", pid);
+    if (readFile(path, buf) < 0) return placement;
+    placement.ok = true;
+
+    std::vector<long long> linePages;
+    for (const char *p = buf.c_str(); *p;) {
+        linePages.clear();
+        long long pageKb = 4;
+        while (*p && *p != '\n') {
+            if (*p == 'N' && p[1] >= '0' && p[1] <= '9' && p[-1] == ' ') {
+                ++p;
+                size_t node = (size_t)parseNumber(p);
+                if (*p == '=') {
+                    ++p;
+                    if (linePages.size() <= node) linePages.resize(node + 1, 0);
+                    linePages[node] += (long long)parseNumber(p);
+                }
+            } else if (strncmp(p, "kernelpagesize_kB=", 18) == 0) {
+                p += 18;
+                pageKb = (long long)parseNumber(p);
+            } else {
+                ++p;
+            }
+        }
+        if (placement.kbPerNode.size() < linePages.size()) placement.kbPerNode.resize(linePages.size(), 0);
+        for (size_t node = 0; node < linePages.size(); ++node) placement.kbPerNode[node] += linePages[node] * pageKb;
+        if (*p == '\n') ++p;
+    }
+    return placement;
+}
+
+// --- Memory Classification ---
+
+/**
+ * @brief Reads PSS and USS from /proc/[pid]/smaps_rollup. The kernel walks every
+ *        mapping to produce it, so it runs on the background reader only.
+ */
+SmapsRollup readSmapsRollup(int pid, long long starttime, std::string &buf) {
+    SmapsRollup r = {};
+    r.starttime = starttime;
+    r.time = monotonicSeconds();
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps_rollup", pid);
+    ssize_t len = readFile(path, buf);
+    if (len < 0) {
+        r.state = (errno == EACCES || errno == EPERM) ? SMAPS_DENIED : SMAPS_GONE;
+        return r;
+    }
+    // Kernel threads and exiting processes have no address space: the file reads empty
+    if (len == 0 || !strstr(buf.c_str(), "\nPss:")) {
+        r.state = SMAPS_GONE;
+        return r;
+    }
+    long privateClean = 0, privateDirty = 0, privateHugetlb = 0;
+    struct { const char *key; long *value; } fields[] = {
+        {"\nPss:", &r.pssKb}, {"\nSwapPss:", &r.swapPssKb},
+        {"\nPrivate_Clean:", &privateClean}, {"\nPrivate_Dirty:", &privateDirty},
+        {"\nPrivate_Hugetlb:", &privateHugetlb},
+    };
+    for (const auto &f : fields) {
+        const char *p = strstr(buf.c_str(), f.key);
+        if (p) {
+            p += strlen(f.key);
+            *f.value = (long)parseNumber(p);
+        }
+    }
+    r.ussKb = privateClean + privateDirty + privateHugetlb;
+    r.state = SMAPS_OK;
+    return r;
+}
+
+// --- Background Reader ---
+
+// Expensive per-process files are read on one background thread. The UI queues
+// jobs and picks up results on a later refresh; it never waits for a read.
+enum BackgroundJobKind { JOB_NUMA_MAPS, JOB_SMAPS_ROLLUP };
+
+struct BackgroundJob {
+    BackgroundJobKind kind;
+    int pid;
+    long long starttime;   // Results for a reused PID are told apart by this
+};
+
+std::mutex backgroundMutex;                 // Guards everything below
+std::condition_variable backgroundWake;
+std::thread backgroundThread;
+std::deque<BackgroundJob> backgroundQueue;
+BackgroundJob backgroundCurrent = {JOB_NUMA_MAPS, -1, 0}; // Job being read, pid -1 if idle
+bool backgroundStop = false;
+NumaPlacement numaPlacement = {-1, false, {}, 0.0};     // Latest numa_maps result
+std::unordered_map<int, SmapsRollup> smapsRollups;      // Latest smaps_rollup result per PID
+
+void backgroundWorker() {
+    std::string buf;
+    std::unique_lock<std::mutex> lock(backgroundMutex);
+    while (true) {
+        backgroundWake.wait(lock, [] { return backgroundStop || !backgroundQueue.empty(); });
+        if (backgroundStop) return;
+        BackgroundJob job = backgroundQueue.front();
+        backgroundQueue.pop_front();
+        backgroundCurrent = job;
+        lock.unlock();
+
+        NumaPlacement placement;
+        SmapsRollup rollup;
+        if (job.kind == JOB_NUMA_MAPS) {
+            placement = readNumaPlacement(job.pid, buf);
+        } else {
+            rollup = readSmapsRollup(job.pid, job.starttime, buf);
+        }
+
+        lock.lock();
+        backgroundCurrent.pid = -1;
+        if (job.kind == JOB_NUMA_MAPS) {
+            numaPlacement = std::move(placement);
+        } else {
+            smapsRollups[job.pid] = rollup;
+        }
+        // Wake the UI once the queue drains, not once per job
+        if (backgroundQueue.empty() && workerWakePipe[1] >= 0 && write(workerWakePipe[1], "", 1) < 0) {
+            // Pipe full: the UI is already due to wake up
+        }
+    }
+}
+
+/**
+ * @brief Whether a job for this PID is queued or being read. Caller holds backgroundMutex.
+ */
+bool backgroundJobPending(BackgroundJobKind kind, int pid) {
+    if (backgroundCurrent.pid == pid && backgroundCurrent.kind == kind) return true;
+    for (const auto &job : backgroundQueue) {
+        if (job.pid == pid && job.kind == kind) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Queues a job, starting the thread on first use. Caller holds backgroundMutex.
+ */
+void postBackgroundJob(BackgroundJobKind kind, int pid, long long starttime) {
+    if (!backgroundThread.joinable()) {
+        if (workerWakePipe[0] < 0 && pipe2(workerWakePipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+            workerWakePipe[0] = workerWakePipe[1] = -1;
+        }
+        backgroundThread = std::thread(backgroundWorker);
+    }
+    backgroundQueue.push_back({kind, pid, starttime});
+    backgroundWake.notify_one();
+}
+
+/**
+ * @brief Asks for the selected process's NUMA placement if the shown one is for
+ *        another process or older than maxAgeSeconds
+ */
+void requestNumaPlacement(int pid, double maxAgeSeconds) {
+    std::lock_guard<std::mutex> lock(backgroundMutex);
+    if (pid <= 0 || backgroundJobPending(JOB_NUMA_MAPS, pid)) return;
+    bool fresh = numaPlacement.pid == pid && monotonicSeconds() - numaPlacement.time < maxAgeSeconds;
+    if (!fresh) postBackgroundJob(JOB_NUMA_MAPS, pid, 0);
+}
+
+/**
+ * @brief Asks for smaps_rollup of the rows on screen whose value is missing or older
+ *        than maxAgeSeconds, and forgets results for processes that have exited
+ */
+void requestSmapsRollups(const std::vector<int> &pids, double maxAgeSeconds) {
+    double now = monotonicSeconds();
+    std::lock_guard<std::mutex> lock(backgroundMutex);
+    for (auto it = smapsRollups.begin(); it != smapsRollups.end();) {
+        if (processTracks.count(it->first) == 0) it = smapsRollups.erase(it);
+        else ++it;
+    }
+    for (int pid : pids) {
+        auto track = processTracks.find(pid);
+        if (track == processTracks.end() || backgroundJobPending(JOB_SMAPS_ROLLUP, pid)) continue;
+        auto it = smapsRollups.find(pid);
+        bool fresh = it != smapsRollups.end() && it->second.starttime == track->second.starttime &&
+                     (now - it->second.time < maxAgeSeconds || it->second.state == SMAPS_DENIED);
+        if (!fresh) postBackgroundJob(JOB_SMAPS_ROLLUP, pid, track->second.starttime);
+    }
+}
+
+/**
+ * @brief Copies the latest PSS/USS into the process snapshot, with their age
+ */
+void attachSmapsRollups(std::vector<Process> &processes) {
+    double now = monotonicSeconds();
+    std::lock_guard<std::mutex> lock(backgroundMutex);
+    for (auto &p : processes) {
+        auto it = smapsRollups.find(p.pid);
+        if (it == smapsRollups.end() || it->second.starttime != p.stat.starttime) continue;
+        p.smapsState = it->second.state;
+        p.pssKb = it->second.pssKb;
+        p.ussKb = it->second.ussKb;
+        p.smapsAge = now - it->second.time;
+    }
+}
+
+void stopBackgroundReader() {
+    if (!backgroundThread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        backgroundStop = true;
+    }
+    backgroundWake.notify_one();
+    backgroundThread.join();
+}
+
+// --- Process Killing ---
+
+/**
+ * @brief Draws a new window to ask for a PID to kill
+ */
+void killProcessWindow() {
+    int y, x;
+    getmaxyx(stdscr, y, x); // Get screen dimensions
+    // Create a small window in the center
+    WINDOW *killWin = newwin(5, 40, y / 2 - 2, x / 2 - 20);
+    box(killWin, 0, 0);
+    wrefresh(killWin);
+
+    mvwprintw(killWin, 1, 2, "Enter PID to kill (or Esc to_cancel):");
+    wattron(killWin, A_REVERSE);
+    mvwprintw(killWin, 2, 2, "                         "); // Input area
+    wattroff(killWin, A_REVERSE);
+
+    echo(); // Turn echo on to see typing
+    keypad(killWin, TRUE); // Enable arrow keys, Esc
+    
+    char pidStr[20];
+    int ch;
+    
+    wmove(killWin, 2, 2); // Move cursor to input area
+    wrefresh(killWin);
+
+    // Get string input, but handle Esc
+    int i = 0;
+    while(true) {
+        ch = wgetch(killWin);
+        if (ch == 27) { // 27 is the Esc key
+            i = -1; // Signal for cancel
+            break;
+        }
+        if (ch == '\n') { // Enter key
+            pidStr[i] = '\0';
+            break;
+        }
+        if (ch == KEY_BACKSPACE || ch == 127) {
+            if (i > 0) {
+                i--;
+                mvwprintw(killWin, 2, 2 + i, " "); // Erase char on screen
+                wmove(killWin, 2, 2 + i);
+            }
+        } else if (isdigit(ch) && i < 19) {
+            pidStr[i] = (char)ch;
+            waddch(killWin, ch);
+            i++;
+        }
+    }
+    
+    noecho(); // Turn echo back off
+    delwin(killWin); // Delete the window
+
+    if (i == -1) return; // User cancelled
+
+    try {
+        int pid = std::stoi(pidStr);
+        // Send SIGTERM (15) - a request to terminate
+        if (kill(pid, SIGTERM) == 0) {
+            // Success
+        } else {
+            // Failed (e.g., no permissions)
+        }
+    } catch (...) {
+        // Invalid PID
+    }
+}
+
+
+/**
+ * @brief Prompts for the process name filter (a case-insensitive substring; empty clears it)
+ */
+void editFilterWindow() {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    WINDOW *filterWin = newwin(5, 44, y / 2 - 2, x / 2 - 22);
+    box(filterWin, 0, 0);
+    mvwprintw(filterWin, 1, 2, "Filter by name (Enter to apply, Esc):");
+    wattron(filterWin, A_REVERSE);
+    mvwprintw(filterWin, 2, 2, "%-38s", processFilter.c_str());
+    wattroff(filterWin, A_REVERSE);
+    keypad(filterWin, TRUE);
+    curs_set(1);
+
+    std::string text = processFilter;
+    while (true) {
+        wmove(filterWin, 2, 2 + (int)text.size());
+        wrefresh(filterWin);
+        int ch = wgetch(filterWin);
+        if (ch == 27) break; // Esc keeps the old filter
+        if (ch == '\n' || ch == KEY_ENTER) {
+            processFilter = text;
+            break;
+        }
+        if (ch == KEY_BACKSPACE || ch == 127) {
+            if (!text.empty()) text.pop_back();
+        } else if (isprint(ch) && text.size() < 38) {
+            text += (char)ch;
+        }
+        wattron(filterWin, A_REVERSE);
+        mvwprintw(filterWin, 2, 2, "%-38s", text.c_str());
+        wattroff(filterWin, A_REVERSE);
+    }
+    curs_set(0);
+    delwin(filterWin);
+}
+
+/**
+ * @brief Copies the processes whose name contains the filter
+ */
+std::vector<Process> filterProcesses(const std::vector<Process> &processes) {
+    std::vector<Process> matching;
+    for (const auto &p : processes) {
+        if (strcasestr(p.name.c_str(), processFilter.c_str()) != NULL) matching.push_back(p);
+    }
+    return matching;
+}
+
+// --- Snapshot History ---
+
+// Snapshots are dropped oldest first once they hold more process rows than this in total
+// (a row is about 1 KB), so a busy machine keeps fewer, a quiet one more; but never fewer
+// than historyMinSnapshots, or a host with 20000 processes would have nothing to step to
+const size_t historyRowBudget = 20000;
+const size_t historyMinSnapshots = 30;
+std::deque<Snapshot> history;
+size_t historyRows = 0;
+unsigned long long historySequence = 0;
+bool historyPaused = false;             // Space: keep collecting, but show historyCursor
+unsigned long long historyCursor = 0;   // Sequence of the snapshot shown while paused
+
+void recordSnapshot(Snapshot &&snapshot) {
+    snapshot.sequence = ++historySequence;
+    historyRows += snapshot.processes.size();
+    history.push_back(std::move(snapshot));
+    while (history.size() > historyMinSnapshots && historyRows > historyRowBudget) {
+        historyRows -= history.front().processes.size();
+        history.pop_front();
+    }
+}
+
+/**
+ * @brief The snapshot to show, or NULL for live data. A paused position that has
+ *        aged out of the history moves to the oldest snapshot left.
+ */
+Snapshot *shownSnapshot() {
+    if (!historyPaused || history.empty()) return NULL;
+    historyCursor = std::max(historyCursor, history.front().sequence);
+    return &history[historyCursor - history.front().sequence];
+}
+
+/**
+ * @brief Pauses (at the newest snapshot) or resumes live display
+ */
+void toggleHistoryPause() {
+    historyPaused = !historyPaused && !history.empty();
+    if (historyPaused) historyCursor = history.back().sequence;
+}
+
+/**
+ * @brief Moves the paused position by one snapshot; stepping back from live pauses first
+ */
+void stepHistory(int direction) {
+    if (history.empty()) return;
+    if (!historyPaused) toggleHistoryPause();
+    long long cursor = (long long)historyCursor + direction;
+    historyCursor = (unsigned long long)std::max((long long)history.front().sequence,
+                                                 std::min((long long)history.back().sequence, cursor));
+}
+
+// --- History Graphs ---
+
+// System CPU busy % and memory used %, and the selected process's CPU% and RSS (KB)
+MinMaxPyramid cpuGraph, memGraph, selectedCpuGraph, selectedRssGraph;
+int graphPid = -1;             // Process the selected* graphs were filled for
+const double graphSpans[] = {60, 300, 900, 3600, 6 * 3600, 24 * 3600};
+const int graphSpanCount = sizeof(graphSpans) / sizeof(graphSpans[0]);
+int graphZoom = 1;             // Index into graphSpans ('+'/'-')
+bool unicodeGraphs = false;    // Braille needs a UTF-8 locale; otherwise plain ASCII
+
+void pyramidAdd(MinMaxPyramid &pyramid, double t, double value) {
+    pyramid.latest = (float)value;
+    for (int level = 0; level < pyramidLevels; ++level) {
+        long long bucket = (long long)(t / std::ldexp(1.0, level));
+        MinMaxBucket &b = pyramid.levels[level][bucket % pyramidBuckets];
+        if (b.slot != bucket + 1) {
+            b = {bucket + 1, (float)value, (float)value};
+        } else {
+            b.min = std::min(b.min, (float)value);
+            b.max = std::max(b.max, (float)value);
+        }
+    }
+}
+
+/**
+ * @brief Min/max per point over [end - span, end) from the finest level whose buckets are
+ *        at least span/points (and minWidth) wide. Points without data are NaN; a missing
+ *        bucket or two (a late refresh) repeats the previous point instead.
+ */
+void pyramidQuery(const MinMaxPyramid &pyramid, double end, double span, int points, double minWidth,
+                  std::vector<float> &mins, std::vector<float> &maxs) {
+    int level = 0;
+    while (level + 1 < pyramidLevels && std::ldexp(1.0, level) < std::max(span / points, minWidth)) level++;
+    double width = std::ldexp(1.0, level);
+    mins.assign(points, NAN);
+    maxs.assign(points, NAN);
+    long long lastBucket = -1;
+    double step = span / points;
+    for (int j = 0; j < points; ++j) {
+        double t = end - span + j * step;
+        if (t < 0.0) continue;
+        // A point overlaps at most two buckets, since buckets are at least a point wide
+        long long first = (long long)(t / width), last = (long long)((t + step) / width);
+        for (long long bucket = first; bucket <= last && bucket <= first + 1; ++bucket) {
+            const MinMaxBucket &b = pyramid.levels[level][bucket % pyramidBuckets];
+            if (b.slot != bucket + 1) continue;
+            mins[j] = std::isnan(mins[j]) ? b.min : std::min(mins[j], b.min);
+            maxs[j] = std::isnan(maxs[j]) ? b.max : std::max(maxs[j], b.max);
+            lastBucket = bucket;
+        }
+        if (std::isnan(maxs[j]) && j > 0 && lastBucket >= 0 && first - lastBucket <= 2) {
+            mins[j] = mins[j - 1];
+            maxs[j] = maxs[j - 1];
+        }
+    }
+}
+
+/**
+ * @brief Feeds the selected process's graphs. A new selection starts them over from the
+ *        snapshot history, so its recent past shows immediately.
+ */
+void updateSelectionGraphs(const std::vector<Process> &processes, double now) {
+    auto add = [](const Process &p, double t) {
+        pyramidAdd(selectedCpuGraph, t, p.cpuPercent);
+        pyramidAdd(selectedRssGraph, t, (double)p.memRssKb);
+    };
+    if (selectedPid != graphPid) {
+        memset(&selectedCpuGraph, 0, sizeof(selectedCpuGraph));
+        memset(&selectedRssGraph, 0, sizeof(selectedRssGraph));
+        graphPid = selectedPid;
+        if (selectedPid < 0) return;
+        for (const auto &snapshot : history) {
+            for (const auto &p : snapshot.processes) {
+                if (p.pid == selectedPid) add(p, snapshot.monotonicTime);
+            }
+        }
+        return; // The history ends with this refresh
+    }
+    for (const auto &p : processes) {
+        if (p.pid == selectedPid) add(p, now);
+    }
+}
+
+// --- Sorting Comparators ---
+bool compareByCpu(const Process &a, const Process &b) {
+    return a.cpuPercent > b.cpuPercent;
+}
+bool compareByMem(const Process &a, const Process &b) {
+    return a.memPercent > b.memPercent;
+}
+bool compareByPid(const Process &a, const Process &b) {
+    return a.pid < b.pid;
+}
+bool compareByIoRead(const Process &a, const Process &b) {
+    return a.ioReadRate > b.ioReadRate;
+}
+bool compareByIoWrite(const Process &a, const Process &b) {
+    return a.ioWriteRate > b.ioWriteRate;
+}
+bool compareBySyscr(const Process &a, const Process &b) {
+    return a.syscrRate > b.syscrRate;
+}
+bool compareBySyscw(const Process &a, const Process &b) {
+    return a.syscwRate > b.syscwRate;
+}
+bool compareByIoDelay(const Process &a, const Process &b) {
+    return a.blkioDelayPercent > b.blkioDelayPercent;
+}
+bool compareByCpuDelay(const Process &a, const Process &b) {
+    return a.cpuDelayPercent > b.cpuDelayPercent;
+}
+
+bool compareByMigrations(const Process &a, const Process &b) {
+    return a.migrations > b.migrations;
+}
+
+bool compareBySchedWait(const Process &a, const Process &b) {
+    return a.schedWaitPercent > b.schedWaitPercent;
+}
+
+bool compareByInvoluntaryCs(const Process &a, const Process &b) {
+    return a.involuntaryCsRate > b.involuntaryCsRate;
+}
+
+bool compareByVoluntaryCs(const Process &a, const Process &b) {
+    return a.voluntaryCsRate > b.voluntaryCsRate;
+}
+
+bool compareByMinflt(const Process &a, const Process &b) {
+    return a.minfltRate > b.minfltRate;
+}
+
+bool compareByMajflt(const Process &a, const Process &b) {
+    return a.majfltRate > b.majfltRate;
+}
+
+bool compareByAnomaly(const Process &a, const Process &b) {
+    return a.anomalyScore > b.anomalyScore;
+}
+
+bool compareByCpu1s(const Process &a, const Process &b) {
+    return a.cpuAverage[0] > b.cpuAverage[0];
+}
+
+bool compareByCpu10s(const Process &a, const Process &b) {
+    return a.cpuAverage[1] > b.cpuAverage[1];
+}
+
+bool compareByCpu60s(const Process &a, const Process &b) {
+    return a.cpuAverage[2] > b.cpuAverage[2];
+}
+
+bool compareByRssGrowth(const Process &a, const Process &b) {
+    // Suspected leaks first, then by growth rate
+    if (a.leakSuspect != b.leakSuspect) return a.leakSuspect;
+    return a.rssGrowthKbPerSec > b.rssGrowthKbPerSec;
+}
+
+/**
+ * @brief Sorts the process list by the current sort mode
+ */
+void sortProcesses(std::vector<Process> &processes) {
+    bool (*compare)(const Process &, const Process &) = compareByCpu;
+    switch (currentSortMode) {
+        case BY_CPU:      compare = compareByCpu; break;
+        case BY_MEM:      compare = compareByMem; break;
+        case BY_PID:      compare = compareByPid; break;
+        case BY_IO_READ:  compare = compareByIoRead; break;
+        case BY_IO_WRITE: compare = compareByIoWrite; break;
+        case BY_SYSCR:    compare = compareBySyscr; break;
+        case BY_SYSCW:    compare = compareBySyscw; break;
+        case BY_IO_DELAY: compare = compareByIoDelay; break;
+        case BY_CPU_DELAY: compare = compareByCpuDelay; break;
+        case BY_MIGRATIONS: compare = compareByMigrations; break;
+        case BY_SCHED_WAIT: compare = compareBySchedWait; break;
+        case BY_NVCSW:      compare = compareByInvoluntaryCs; break;
+        case BY_VCSW:       compare = compareByVoluntaryCs; break;
+        case BY_MINFLT:     compare = compareByMinflt; break;
+        case BY_MAJFLT:     compare = compareByMajflt; break;
+        case BY_RSS_GROWTH: compare = compareByRssGrowth; break;
+        case BY_ANOMALY:    compare = compareByAnomaly; break;
+        case BY_CPU_1S:     compare = compareByCpu1s; break;
+        case BY_CPU_10S:    compare = compareByCpu10s; break;
+        case BY_CPU_60S:    compare = compareByCpu60s; break;
+        case SORT_MODE_COUNT: break;
+    }
+    std::sort(processes.begin(), processes.end(), compare);
+}
+
+const char *sortModeName(SortMode mode) {
+    switch (mode) {
+        case BY_CPU:      return "CPU%";
+        case BY_MEM:      return "MEM%";
+        case BY_PID:      return "PID";
+        case BY_IO_READ:  return "READ/s";
+        case BY_IO_WRITE: return "WRITE/s";
+        case BY_SYSCR:    return "SYSCR/s";
+        case BY_SYSCW:    return "SYSCW/s";
+        case BY_IO_DELAY: return "IO-DLY%";
+        case BY_CPU_DELAY: return "CPU-DLY%";
+        case BY_MIGRATIONS: return "MIGR";
+        case BY_SCHED_WAIT: return "WAIT%";
+        case BY_NVCSW:      return "NVCSW/s";
+        case BY_VCSW:       return "VCSW/s";
+        case BY_MINFLT:     return "MINFLT/s";
+        case BY_MAJFLT:     return "MAJFLT/s";
+        case BY_RSS_GROWTH: return "GROWTH";
+        case BY_ANOMALY:    return "ANOMALY";
+        case BY_CPU_1S:     return "CPU1s";
+        case BY_CPU_10S:    return "CPU10s";
+        case BY_CPU_60S:    return "CPU60s";
+        case SORT_MODE_COUNT: break;
+    }
+    return "";
+}
+
+// Group sorting follows the process sort mode ('p' sorts by the group key)
+bool compareGroups(const ProcessGroup &a, const ProcessGroup &b) {
+    if (currentSortMode == BY_CPU) return a.cpuPercent > b.cpuPercent;
+    if (currentSortMode == BY_MEM) return a.memRssKb > b.memRssKb;
+    if (a.numericKey != b.numericKey) return a.numericKey < b.numericKey;
+    return a.key < b.key;
+}
+
+
+// --- Aggregation ---
+
+/**
+ * @brief Single-pass hash aggregation of a process snapshot.
+ *        Keys are views into the snapshot (or plain integers), so the only
+ *        allocations are one label per distinct group.
+ * @param keyOf Extracts the grouping key from a process
+ * @param labelOf Builds the display label for a new group
+ */
+template <typename Key, typename KeyFn, typename LabelFn>
+std::vector<ProcessGroup> aggregateProcesses(const std::vector<Process> &processes, KeyFn keyOf, LabelFn labelOf) {
+    std::vector<ProcessGroup> groups;
+    std::unordered_map<Key, size_t> index;
+    index.reserve(processes.size() / 4 + 16);
+
+    for (const auto &p : processes) {
+        auto inserted = index.emplace(keyOf(p), groups.size());
+        if (inserted.second) {
+            groups.push_back({labelOf(p), 0, 0, 0.0, 0.0, 0, 0.0, 0});
+        }
+        ProcessGroup &g = groups[inserted.first->second];
+        g.count++;
+        g.cpuPercent += p.cpuPercent;
+        g.memPercent += p.memPercent;
+        g.memRssKb += p.memRssKb;
+        g.maxCpuPercent = std::max(g.maxCpuPercent, p.cpuPercent);
+        g.maxRssKb = std::max(g.maxRssKb, p.memRssKb);
+    }
+    return groups;
+}
+
+/**
+ * @brief Groups a process snapshot by the current group-by key and sorts the groups
+ */
+std::vector<ProcessGroup> groupProcesses(const std::vector<Process> &processes, GroupBy groupBy) {
+    std::vector<ProcessGroup> groups;
+    switch (groupBy) {
+        case GROUP_BY_SERVICE:
+            groups = aggregateProcesses<std::string_view>(processes,
+                [](const Process &p) { return std::string_view(p.service); },
+                [](const Process &p) { return p.service; });
+            break;
+        case GROUP_BY_USER:
+            groups = aggregateProcesses<std::string_view>(processes,
+                [](const Process &p) { return std::string_view(p.user); },
+                [](const Process &p) { return p.user; });
+            break;
+        case GROUP_BY_COMM:
+            groups = aggregateProcesses<std::string_view>(processes,
+                [](const Process &p) { return std::string_view(p.name); },
+                [](const Process &p) { return p.name; });
+            break;
+        case GROUP_BY_PPID: {
+            groups = aggregateProcesses<int>(processes,
+                [](const Process &p) { return p.stat.ppid; },
+                [](const Process &p) { return std::to_string(p.stat.ppid); });
+            // Label each parent with its name (one lookup per group, not per process)
+            std::unordered_map<int, const Process *> byPid;
+            byPid.reserve(processes.size());
+            for (const auto &p : processes) byPid[p.pid] = &p;
+            for (auto &g : groups) {
+                g.numericKey = std::stol(g.key);
+                auto it = byPid.find((int)g.numericKey);
+                if (it != byPid.end()) g.key += " (" + it->second->name + ")";
+            }
+            break;
+        }
+        case GROUP_BY_SESSION:
+            groups = aggregateProcesses<int>(processes,
+                [](const Process &p) { return p.stat.session; },
+                [](const Process &p) { return std::to_string(p.stat.session); });
+            for (auto &g : groups) g.numericKey = std::stol(g.key);
+            break;
+    }
+    std::sort(groups.begin(), groups.end(), compareGroups);
+    return groups;
+}
+
+const char *groupByName(GroupBy groupBy) {
+    switch (groupBy) {
+        case GROUP_BY_SERVICE: return "SERVICE";
+        case GROUP_BY_USER:    return "USER";
+        case GROUP_BY_COMM:    return "COMMAND";
+        case GROUP_BY_PPID:    return "PPID";
+        case GROUP_BY_SESSION: return "SESSION";
+    }
+    return "";
+}
+
+
+// --- Drawing Functions ---
+
+/**
+ * @brief Header text for the optional columns (service, current column set)
+ */
+std::string extraColumnsHeader() {
+    char buf[128];
+    std::string header;
+    if (showServiceColumn) {
+        snprintf(buf, sizeof(buf), "%-24s ", "SERVICE");
+        header += buf;
+    }
+    if (currentColumnSet == COLS_IO) {
+        snprintf(buf, sizeof(buf), "%8s %8s %7s %7s ", "READ/s", "WRITE/s", "SYSCR/s", "SYSCW/s");
+        header += buf;
+    } else if (currentColumnSet == COLS_CPU) {
+        snprintf(buf, sizeof(buf), "%4s %5s %1s %-12s ", "LCPU", "MIGR", "S", "AFFINITY");
+        header += buf;
+    } else if (currentColumnSet == COLS_SCHED) {
+        snprintf(buf, sizeof(buf), "%6s %7s %7s %7s ", "WAIT%", "SLICE/s", "VCSW/s", "NVCSW/s");
+        header += buf;
+    } else if (currentColumnSet == COLS_FAULTS) {
+        snprintf(buf, sizeof(buf), "%9s %9s ", "MINFLT/s", "MAJFLT/s");
+        header += buf;
+    } else if (currentColumnSet == COLS_MEMORY) {
+        snprintf(buf, sizeof(buf), "%7s %7s %7s %7s %8s %8s ", "ANON", "FILE", "SHMEM", "SWAP", "PSS", "USS");
+        header += buf;
+    } else if (currentColumnSet == COLS_LEAK) {
+        snprintf(buf, sizeof(buf), "%8s %9s %4s %9s %8s ", "RSS", "GROW-MB/h", "FIT", "EXHAUST", "SAMPLED");
+        header += buf;
+    } else if (currentColumnSet == COLS_ANOMALY) {
+        snprintf(buf, sizeof(buf), "%6s %6s %5s %8s %8s %5s %5s ", "CPU~", "CPU-SD", "zCPU", "RSS~", "RSS-SD",
+                 "zRSS", "SCORE");
+        header += buf;
+    } else if (currentColumnSet == COLS_CPU_AVERAGE) {
+        snprintf(buf, sizeof(buf), "%6s %6s %6s ", "CPU1s", "CPU10s", "CPU60s");
+        header += buf;
+    } else if (currentColumnSet == COLS_PERCENTILES) {
+        snprintf(buf, sizeof(buf), "%5s %5s %5s %5s %7s %7s %7s %7s ", "CPU50", "CPU95", "CPU99", "CPUMX", "RSS50",
+                 "RSS95", "RSS99", "RSSMX");
+        header += buf;
+    }
+    return header;
+}
+
+/**
+ * @brief Formats the optional columns of one process row, matching extraColumnsHeader()
+ */
+std::string extraColumns(const Process &p) {
+    char buf[128];
+    std::string columns;
+    if (showServiceColumn) {
+        snprintf(buf, sizeof(buf), "%-24.24s ", p.service.c_str());
+        columns += buf;
+    }
+    if (currentColumnSet == COLS_IO) {
+        if (p.ioState == IO_OK) {
+            snprintf(buf, sizeof(buf), "%8s %8s %7.0f %7.0f ",
+                     formatBytes(p.ioReadRate).c_str(), formatBytes(p.ioWriteRate).c_str(),
+                     p.syscrRate, p.syscwRate);
+        } else {
+            // Exited between reads, or not permitted (marked once, never retried)
+            const char *mark = (p.ioState == IO_DENIED) ? "n/a" : "-";
+            snprintf(buf, sizeof(buf), "%8s %8s %7s %7s ", mark, mark, mark, mark);
+        }
+        columns += buf;
+    } else if (currentColumnSet == COLS_CPU) {
+        snprintf(buf, sizeof(buf), "%4d %5d %c %-12.12s ", p.stat.processor, p.migrations, p.stat.state,
+                 p.affinity.c_str());
+        columns += buf;
+    } else if (currentColumnSet == COLS_SCHED) {
+        // schedstat is missing without CONFIG_SCHEDSTATS; the switch counts are always there
+        char wait[16] = "n/a", slices[16] = "n/a";
+        if (p.schedOk) {
+            snprintf(wait, sizeof(wait), "%.1f", p.schedWaitPercent);
+            snprintf(slices, sizeof(slices), "%.0f", p.slicesRate);
+        }
+        snprintf(buf, sizeof(buf), "%6s %7s %7.0f %7.0f ", wait, slices, p.voluntaryCsRate, p.involuntaryCsRate);
+        columns += buf;
+    } else if (currentColumnSet == COLS_FAULTS) {
+        snprintf(buf, sizeof(buf), "%9.0f %9.0f ", p.minfltRate, p.majfltRate);
+        columns += buf;
+    } else if (currentColumnSet == COLS_MEMORY) {
+        auto kb = [](long value) { return formatBytes(value * 1024.0); };
+        // PSS/USS arrive in the background: "..." until the first read, '~' once older than a refresh cycle
+        char pss[16] = "...", uss[16] = "...";
+        if (p.smapsState == SMAPS_OK) {
+            const char *stale = p.smapsAge > smapsMaxAgeSeconds ? "~" : " ";
+            snprintf(pss, sizeof(pss), "%s%s", kb(p.pssKb).c_str(), stale);
+            snprintf(uss, sizeof(uss), "%s%s", kb(p.ussKb).c_str(), stale);
+        } else if (p.smapsState != SMAPS_NOT_READ) {
+            // Not permitted, or no address space (kernel threads)
+            const char *mark = p.smapsState == SMAPS_DENIED ? "n/a " : "- ";
+            snprintf(pss, sizeof(pss), "%s", mark);
+            snprintf(uss, sizeof(uss), "%s", mark);
+        }
+        snprintf(buf, sizeof(buf), "%7s %7s %7s %7s %8s %8s ", kb(p.rssAnonKb).c_str(), kb(p.rssFileKb).c_str(),
+                 kb(p.rssShmemKb).c_str(), kb(p.swapKb).c_str(), pss, uss);
+        columns += buf;
+    } else if (currentColumnSet == COLS_LEAK) {
+        // The exhaustion estimate is only shown for suspected leaks; noise would extrapolate to nonsense
+        std::string exhaust = p.leakSuspect ? formatDuration(p.exhaustSeconds) : "-";
+        snprintf(buf, sizeof(buf), "%8s %9.1f %4.2f %8s%c %8s ", formatBytes(p.memRssKb * 1024.0).c_str(),
+                 p.rssGrowthKbPerSec * 3600.0 / 1024.0, p.rssGrowthFit, exhaust.c_str(), p.leakSuspect ? '!' : ' ',
+                 formatDuration(p.rssObservedSeconds).c_str());
+        columns += buf;
+    } else if (currentColumnSet == COLS_ANOMALY) {
+        snprintf(buf, sizeof(buf), "%6.1f %6.1f %5.1f %8s %8s %5.1f %5.1f ", p.cpuBaseline, p.cpuDeviation, p.cpuScore,
+                 formatBytes(p.rssBaseline * 1024.0).c_str(), formatBytes(p.rssDeviation * 1024.0).c_str(),
+                 p.rssScore, p.anomalyScore);
+        columns += buf;
+    } else if (currentColumnSet == COLS_CPU_AVERAGE) {
+        snprintf(buf, sizeof(buf), "%6.1f %6.1f %6.1f ", p.cpuAverage[0], p.cpuAverage[1], p.cpuAverage[2]);
+        columns += buf;
+    } else if (currentColumnSet == COLS_PERCENTILES) {
+        const Percentiles &c = p.cpuPercentiles, &r = p.rssPercentiles;
+        auto kb = [](double value) { return formatBytes(value * 1024.0); };
+        snprintf(buf, sizeof(buf), "%5.1f %5.1f %5.1f %5.1f %7s %7s %7s %7s ", c.p50, c.p95, c.p99, c.max,
+                 kb(r.p50).c_str(), kb(r.p95).c_str(), kb(r.p99).c_str(), kb(r.max).c_str());
+        columns += buf;
+    }
+    return columns;
+}
+
+/**
+ * @brief Draws the main UI headers
+ */
+void drawHeader() {
+    // Get screen size
+    int y, x;
+    getmaxyx(stdscr, y, x);
+
+    // Enable color
+    attron(COLOR_PAIR(1));
+    // Draw top bar
+    mvhline(0, 0, ' ', x);
+    if (currentView == VIEW_CGROUPS) {
+        mvprintw(0, 1, "SysMon cgroups (Press 'g' for processes, Up/Down to move, Enter to collapse/expand)");
+    } else if (currentView == VIEW_IOTOP) {
+        mvprintw(0, 1, "SysMon I/O [%s] (Press 'o' for processes, '<'/'>' to sort)", taskstatsStatus.c_str());
+    } else if (currentView == VIEW_GROUPS) {
+        mvprintw(0, 1, "SysMon groups (Press 'G' for processes, 'b' to change grouping, 'c'/'m'/'p' to sort)");
+    } else if (currentView == VIEW_GRAPHS) {
+        mvprintw(0, 1, "SysMon history, last %s (Press 'h' for processes, '+'/'-' to zoom)",
+                 formatDuration(graphSpans[graphZoom]).c_str());
+    } else if (currentView == VIEW_EXITED) {
+        mvprintw(0, 1, "SysMon exited processes, %s: %llu exits (Press 'x' for processes)", exitEventStatus.c_str(),
+                 exitCount);
+        if (exitEventOverruns > 0) {
+            attron(COLOR_PAIR(4) | A_BOLD);
+            printw("  kernel dropped events %llu times", exitEventOverruns);
+            attroff(COLOR_PAIR(4) | A_BOLD);
+        }
+    } else if (currentView == VIEW_TOP_CONSUMERS) {
+        mvprintw(0, 1, "SysMon top consumers, %s (Press 'T' for processes, 'w' for %s)",
+                 showWindowedConsumers ? "last 10 min" : "since start",
+                 showWindowedConsumers ? "since start" : "last 10 min");
+    } else if (currentView == VIEW_CORES) {
+        mvprintw(0, 1, "SysMon cores (Press 'C' for processes; processes by the CPU they last ran on)");
+    } else if (currentView == VIEW_INTERRUPTS) {
+        mvprintw(0, 1, "SysMon interrupts (Press 'I' for processes; rates per second, one column per CPU)");
+    } else {
+        mvprintw(0, 1, "SysMon (Press 'q' to quit, 'c'/'m'/'p' or '<'/'>' to sort, 'f' for columns, 'k' to kill, 'g' for cgroups)");
+    }
+    std::string sortLabel = std::string("Sort: ") + sortModeName(currentSortMode);
+    if (!processFilter.empty()) sortLabel = "Filter: " + processFilter + "  " + sortLabel;
+    if (const Snapshot *shown = shownSnapshot()) {
+        // Position among the kept snapshots, and how long ago it was taken
+        char when[16], position[96];
+        strftime(when, sizeof(when), "%H:%M:%S", localtime(&shown->wallTime));
+        snprintf(position, sizeof(position), "PAUSED %s (-%s, %llu/%zu)  ", when,
+                 formatDuration((double)(time(NULL) - shown->wallTime)).c_str(),
+                 shown->sequence - history.front().sequence + 1, history.size());
+        sortLabel = position + sortLabel;
+    }
+    if (x > (int)sortLabel.size() + 2) mvprintw(0, x - (int)sortLabel.size() - 1, "%s", sortLabel.c_str());
+    
+    // Draw list header
+    mvhline(listHeaderRow, 0, ' ', x);
+    if (currentView == VIEW_CGROUPS) {
+        mvprintw(listHeaderRow, 1, "%6s %8s %8s %8s %8s %5s %5s %5s  %s", "CPU%", "MEM", "MEMMAX", "IO-R/s", "IO-W/s",
+                 "CPU-P", "MEM-P", "IO-P", "CGROUP");
+    } else if (currentView == VIEW_IOTOP) {
+        mvprintw(listHeaderRow, 1, "%-6s %-10s %8s %8s %8s %8s %8s %8s %s", "PID", "USER", "READ/s", "WRITE/s",
+                 "CPU-DLY%", "IO-DLY%", "SWAP-DLY", "RECL-DLY", "COMMAND");
+    } else if (currentView == VIEW_GRAPHS) {
+        mvprintw(listHeaderRow, 1, "Each column is the min-max range of its interval, so short spikes stay visible");
+    } else if (currentView == VIEW_EXITED) {
+        mvprintw(listHeaderRow, 1, "%-16s %7s %9s %9s", "COMMAND", "EXITS", "CPU-SEC", "PEAK-RSS");
+        if (x > 48 + 40) {
+            mvprintw(listHeaderRow, 48, "%7s %7s %-10s %8s %9s %9s %6s %6s %s", "PID", "PPID", "USER", "CPU-SEC",
+                     "PEAK-RSS", "LIFETIME", "EXIT", "AGO", "COMMAND");
+        }
+    } else if (currentView == VIEW_TOP_CONSUMERS) {
+        for (int t = 0; t < 2 && 1 + t * 64 + 32 <= x; ++t) {
+            mvprintw(listHeaderRow, 1 + t * 64, "%-20s %10s %8s %9s %8s", t == 0 ? "COMMAND" : "USER", "CPU-SEC",
+                     "+-ERR", "PEAK-RSS", "PROCS");
+        }
+    } else if (currentView == VIEW_CORES) {
+        mvprintw(listHeaderRow, 1, "%-5s %6s  %s", "CORE", "BUSY%",
+                 "PROCESSES: name/pid CPU% (* = running now, ! = migrated since last refresh)");
+    } else if (currentView == VIEW_INTERRUPTS) {
+        // CPU ruler: the last digit of each CPU number, the tens digit every 10 CPUs above it
+        mvprintw(listHeaderRow, 1, "%-10s %9s %9s %5s %4s", "SOURCE", "TOTAL", "MAXCPU", "CPU", "IMB");
+        for (int c = 0; c < (int)irqCpuCount && 45 + c < x - 2; ++c) {
+            mvaddch(listHeaderRow, 45 + c, (c % 10 == 0) ? '0' + (c / 10) % 10 : '0' + c % 10);
+        }
+    } else if (currentView == VIEW_GROUPS) {
+        mvprintw(listHeaderRow, 1, "%-32s %6s %6s %6s %6s %8s %8s %5s %5s %5s %5s %7s %7s %7s %7s",
+                 groupByName(currentGroupBy), "PROCS", "CPU%", "MAXCPU", "MEM%", "RSS", "MAXRSS", "CPU50", "CPU95",
+                 "CPU99", "CPUMX", "RSS50", "RSS95", "RSS99", "RSSMX");
+    } else {
+        mvprintw(listHeaderRow, 1, "%-6s %-10s %-6s %-6s %s%s", "PID", "USER", "CPU%", "MEM%",
+                 extraColumnsHeader().c_str(), "COMMAND");
+    }
+    attroff(COLOR_PAIR(1));
+}
+
+/**
+ * @brief Draws a CPU bar stacked by mode: user, nice, system, irq, iowait, steal, guest.
+ *        Each mode has its own color and character, so it also reads without color.
+ */
+void drawCpuBar(int row, int col, int barWidth, const CpuBreakdown &b) {
+    const double modes[] = {b.user, b.nice, b.system, b.irq, b.iowait, b.steal, b.guest};
+    const char symbols[] = {'|', ':', '#', '*', 'w', 's', 'g'};
+    mvaddch(row, col, '[');
+    int filled = 0;
+    double cumulative = 0.0;
+    for (int m = 0; m < 7; ++m) {
+        // Round the running total so segments always add up to the whole bar
+        cumulative += modes[m];
+        int end = std::min(barWidth, (int)std::round(cumulative / 100.0 * barWidth));
+        attron(COLOR_PAIR(2 + m));
+        for (; filled < end; ++filled) {
+            mvaddch(row, col + 1 + filled, symbols[m]);
+        }
+        attroff(COLOR_PAIR(2 + m));
+    }
+    for (; filled < barWidth; ++filled) {
+        mvaddch(row, col + 1 + filled, ' ');
+    }
+    mvaddch(row, col + 1 + barWidth, ']');
+}
+
+/**
+ * @brief Draws the system summary (CPU, per-core CPU, load and scheduler activity, Mem)
+ * @return The first row below the summary
+ */
+int drawSystemInfo(const CpuBreakdown &cpu, const std::vector<CpuBreakdown> &cores, const SchedActivity &sched,
+                   long memUsed, long memTotal) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+
+    // 1. CPU, stacked by mode with a numeric breakdown
+    int barWidth = 20;
+    int row = 2;
+    mvprintw(row, 1, "CPU");
+    drawCpuBar(row, 5, barWidth, cpu);
+    mvprintw(row, 5 + barWidth + 2, " %5.1f%%  us %4.1f ni %4.1f sy %4.1f irq %4.1f wa %4.1f st %4.1f gu %4.1f",
+             cpu.busy, cpu.user, cpu.nice, cpu.system, cpu.irq, cpu.iowait, cpu.steal, cpu.guest);
+    row++;
+
+    // 2. Per core, as many cells per row as fit, using at most half the screen
+    if (showPerCoreCpu && !cores.empty()) {
+        const int cellWidth = 58;
+        int columns = std::max(1, x / cellWidth);
+        int maxRows = std::max(1, y / 2 - row);
+        for (size_t i = 0; i < cores.size(); ++i) {
+            int cellRow = row + (int)i / columns;
+            if (cellRow - row >= maxRows) {
+                mvprintw(row + maxRows, 1, "(+%zu more cores)", cores.size() - i);
+                row++;
+                break;
+            }
+            int col = 1 + ((int)i % columns) * cellWidth;
+            const CpuBreakdown &c = cores[i];
+            mvprintw(cellRow, col, "%3d", c.cpu);
+            drawCpuBar(cellRow, col + 4, 10, c);
+            mvprintw(cellRow, col + 17, "%5.1f%% us%5.1f sy%5.1f wa%5.1f st%5.1f", c.busy, c.user, c.system, c.iowait,
+                     c.steal);
+        }
+        row += std::min(maxRows, ((int)cores.size() + columns - 1) / columns);
+    }
+
+    // 3. Load and scheduler activity; a fork storm shows up here before anywhere else
+    const double forkStormRate = 500.0;
+    mvprintw(row, 1, "Load %.2f %.2f %.2f  Tasks %ld/%ld  Run %ld Blk %ld  Ctxt/s %.0f  Intr/s %.0f  Forks/s ",
+             sched.load1, sched.load5, sched.load15, sched.runnable, sched.threads, sched.procsRunning,
+             sched.procsBlocked, sched.ctxtRate, sched.intrRate);
+    bool forkStorm = sched.forkRate >= forkStormRate;
+    if (forkStorm) attron(COLOR_PAIR(4) | A_BOLD);
+    printw("%.0f", sched.forkRate);
+    if (forkStorm) attroff(COLOR_PAIR(4) | A_BOLD);
+    row++;
+
+    // 4. Memory
+    double memPercent = 100.0 * (double)memUsed / (double)memTotal;
+    int memBlocks = (int)std::round(memPercent / 100.0 * barWidth);
+    std::string memBar = "";
+    for(int i = 0; i < barWidth; ++i) {
+        memBar += (i < memBlocks) ? "|" : " ";
+    }
+    mvprintw(row++, 1, "Mem [%s] %5.1f%% (%ld/%ld KB)", memBar.c_str(), memPercent, memUsed, memTotal);
+    return row;
+}
+
+/**
+ * @brief Draws the disk panel: the busiest devices, plus a total over whole disks
+ *        (partitions and virtual layers are hidden unless 'D' is toggled, so the
+ *        total never counts the same I/O twice)
+ * @return The first row below the panel
+ */
+int drawDiskPanel(int row) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    const int maxDevices = 6;
+
+    static std::vector<const DiskStat *> shown;
+    shown.clear();
+    DiskStat total = {};
+    int wholeDisks = 0;
+    for (const auto &d : diskStats) {
+        if (d.kind == DISK_WHOLE) {
+            wholeDisks++;
+            total.readIops += d.readIops;
+            total.writeIops += d.writeIops;
+            total.readBps += d.readBps;
+            total.writeBps += d.writeBps;
+            total.utilPercent = std::max(total.utilPercent, d.utilPercent);
+            total.awaitMs += d.awaitMs * (d.readIops + d.writeIops); // Weighted by IOPS
+        }
+        if (d.kind == DISK_WHOLE || showAllDisks) shown.push_back(&d);
+    }
+    double totalIops = total.readIops + total.writeIops;
+    total.awaitMs = (totalIops > 0.0) ? total.awaitMs / totalIops : 0.0;
+
+    size_t count = std::min(shown.size(), (size_t)maxDevices);
+    std::partial_sort(shown.begin(), shown.begin() + count, shown.end(),
+                      [](const DiskStat *a, const DiskStat *b) {
+                          if (a->utilPercent != b->utilPercent) return a->utilPercent > b->utilPercent;
+                          return a->readBps + a->writeBps > b->readBps + b->writeBps;
+                      });
+
+    attron(A_BOLD);
+    mvprintw(row++, 1, "%-14s %7s %7s %8s %8s %7s %6s", "DISK", "r/s", "w/s", "READ/s", "WRITE/s", "await", "util%");
+    attroff(A_BOLD);
+    auto drawDisk = [&](const char *name, const DiskStat &d) {
+        if (row >= y) return;
+        char line[x + 1];
+        snprintf(line, x, "%-14.14s %7.0f %7.0f %8s %8s %7.2f %6.1f", name, d.readIops, d.writeIops,
+                 formatBytes(d.readBps).c_str(), formatBytes(d.writeBps).c_str(), d.awaitMs, d.utilPercent);
+        mvprintw(row++, 1, "%s", line);
+    };
+    for (size_t i = 0; i < count; ++i) {
+        drawDisk(shown[i]->name, *shown[i]);
+    }
+    char label[32];
+    snprintf(label, sizeof(label), "total (%d)", wholeDisks);
+    drawDisk(label, total);
+    return row;
+}
+
+/**
+ * @brief Draws the network panel. Physical interfaces are listed individually;
+ *        virtual ones are listed while there are few of them and otherwise
+ *        collapsed into one row per name prefix ("veth* (1200)").
+ * @return The first row below the panel
+ */
+int drawNetPanel(int row) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    const int maxInterfaces = 6;
+    const size_t maxVirtualRows = 4;
+
+    struct Row {
+        char name[24];
+        NetStat totals;
+        int members;
+    };
+    static std::vector<Row> rows;
+    rows.clear();
+
+    size_t virtualCount = 0;
+    for (const auto &n : netStats) {
+        if (n.isVirtual) virtualCount++;
+    }
+    bool collapseVirtual = virtualCount > maxVirtualRows;
+
+    for (const auto &n : netStats) {
+        if (n.isVirtual && hideVirtualNet) continue;
+        Row r = {};
+        snprintf(r.name, sizeof(r.name), "%s", n.name);
+        if (n.isVirtual && collapseVirtual) {
+            // Known prefix ("veth", "cali", "br-"), else everything before the first digit
+            size_t len = virtualInterfacePrefix(n.name);
+            if (len == 0) len = strcspn(n.name, "0123456789");
+            snprintf(r.name, sizeof(r.name), "%.*s*", (int)len, n.name);
+        }
+        Row *target = NULL;
+        if (n.isVirtual && collapseVirtual) {
+            for (auto &existing : rows) {
+                if (strcmp(existing.name, r.name) == 0) target = &existing;
+            }
+        }
+        if (!target) {
+            rows.push_back(r);
+            target = &rows.back();
+        }
+        target->members++;
+        target->totals.rxBps += n.rxBps;
+        target->totals.txBps += n.txBps;
+        target->totals.rxPps += n.rxPps;
+        target->totals.txPps += n.txPps;
+        target->totals.dropsPerSec += n.dropsPerSec;
+        target->totals.errorsPerSec += n.errorsPerSec;
+    }
+
+    size_t count = std::min(rows.size(), (size_t)maxInterfaces);
+    std::partial_sort(rows.begin(), rows.begin() + count, rows.end(), [](const Row &a, const Row &b) {
+        return a.totals.rxBps + a.totals.txBps > b.totals.rxBps + b.totals.txBps;
+    });
+
+    attron(A_BOLD);
+    mvprintw(row++, 1, "%-14s %8s %8s %8s %8s %7s %7s", "IFACE", "RX/s", "TX/s", "RXpkt/s", "TXpkt/s",
+             "drop/s", "err/s");
+    attroff(A_BOLD);
+    for (size_t i = 0; i < count && row < y; ++i) {
+        const Row &r = rows[i];
+        char name[48];
+        if (r.members > 1) {
+            snprintf(name, sizeof(name), "%s (%d)", r.name, r.members);
+        } else {
+            snprintf(name, sizeof(name), "%s", r.name);
+        }
+        char line[x + 1];
+        snprintf(line, x, "%-14.14s %8s %8s %8.0f %8.0f %7.0f %7.0f", name,
+                 formatBytes(r.totals.rxBps).c_str(), formatBytes(r.totals.txBps).c_str(),
+                 r.totals.rxPps, r.totals.txPps, r.totals.dropsPerSec, r.totals.errorsPerSec);
+        if (r.totals.dropsPerSec > 0.0 || r.totals.errorsPerSec > 0.0) attron(A_BOLD);
+        mvprintw(row++, 1, "%s", line);
+        attroff(A_BOLD);
+    }
+    if (rows.size() > count && row < y) {
+        mvprintw(row++, 1, "(+%zu more)", rows.size() - count);
+    }
+    return row;
+}
+
+/**
+ * @brief Draws the PSI panel: some/full averages and current stall rate per resource
+ * @return The first row below the panel
+ */
+int drawPsiPanel(int row) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+
+    attron(A_BOLD);
+    mvprintw(row++, 1, "%-8s %6s %6s %6s %8s   %6s %6s %6s %8s", "PSI", "some10", "60", "300", "stall/s",
+             "full10", "60", "300", "stall/s");
+    attroff(A_BOLD);
+    for (const auto &r : psiResources) {
+        if (row >= y) break;
+        if (!r.available) {
+            mvprintw(row++, 1, "%-8s (not available)", r.name);
+            continue;
+        }
+        char line[x + 1];
+        snprintf(line, x, "%-8s %6.2f %6.2f %6.2f %6.0fms   %6.2f %6.2f %6.2f %6.0fms", r.name,
+                 r.some.avg10, r.some.avg60, r.some.avg300, r.some.stallRate,
+                 r.full.avg10, r.full.avg60, r.full.avg300, r.full.stallRate);
+        if (r.some.avg10 >= 10.0) attron(A_BOLD);
+        mvprintw(row++, 1, "%s", line);
+        attroff(A_BOLD);
+    }
+    if (row < y) {
+        if (psiTriggerFds.empty()) {
+            mvprintw(row++, 1, "triggers: not supported, sampling every refresh");
+        } else if (lastPsiEvent) {
+            mvprintw(row++, 1, "triggers: %zu armed, %d stall events, last: %s %.0fs ago", psiTriggerFds.size(),
+                     psiEventCount, lastPsiEvent, monotonicSeconds() - lastPsiEventTime);
+        } else {
+            mvprintw(row++, 1, "triggers: %zu armed, no stall events", psiTriggerFds.size());
+        }
+    }
+    return row;
+}
+
+/**
+ * @brief Draws the NUMA panel: memory and allocation rates per node, then where the
+ *        selected process's memory lives (read in the background from numa_maps)
+ * @return The first row below the panel
+ */
+int drawNumaPanel(int row, const std::vector<Process> &processes) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+
+    attron(A_BOLD);
+    mvprintw(row++, 1, "%-6s %8s %6s %8s %8s %9s %9s %9s %9s", "NUMA", "TOTAL", "USED%", "FILE", "ANON",
+             "HIT/s", "MISS/s", "FOREIGN/s", "REMOTE/s");
+    attroff(A_BOLD);
+    if (numaNodes.empty() && row < y) mvprintw(row++, 1, "(no NUMA information in /sys/devices/system/node)");
+    for (const auto &n : numaNodes) {
+        if (row >= y) break;
+        double used = n.memTotal > 0 ? 100.0 * (double)(n.memTotal - n.memFree) / (double)n.memTotal : 0.0;
+        char line[x + 1];
+        snprintf(line, x, "node%-2d %8s %6.1f %8s %8s %9.0f %9.0f %9.0f %9.0f", n.id,
+                 formatBytes(n.memTotal * 1024.0).c_str(), used, formatBytes(n.filePages * 1024.0).c_str(),
+                 formatBytes(n.anonPages * 1024.0).c_str(), n.hitRate, n.missRate, n.foreignRate, n.otherRate);
+        // More than 1% of allocations landing on the wrong node is worth a look
+        bool misplaced = n.missRate + n.foreignRate > 0.01 * n.hitRate && n.missRate + n.foreignRate > 0.0;
+        if (misplaced) attron(A_BOLD);
+        mvprintw(row++, 1, "%s", line);
+        if (misplaced) attroff(A_BOLD);
+    }
+    if (row >= y) return row;
+
+    std::string name = "?";
+    for (const auto &p : processes) {
+        if (p.pid == selectedPid) name = p.name;
+    }
+    NumaPlacement placement;
+    bool reading;
+    {
+        std::lock_guard<std::mutex> lock(backgroundMutex);
+        placement = numaPlacement;
+        reading = backgroundJobPending(JOB_NUMA_MAPS, selectedPid);
+    }
+    if (selectedPid < 0) {
+        mvprintw(row++, 1, "Select a process with Up/Down to see its memory per node");
+    } else if (placement.pid != selectedPid) {
+        mvprintw(row++, 1, "PID %d %s: %s", selectedPid, name.c_str(), reading ? "reading numa_maps..." : "-");
+    } else if (!placement.ok) {
+        mvprintw(row++, 1, "PID %d %s: numa_maps not readable", selectedPid, name.c_str());
+    } else {
+        long long total = 0;
+        for (long long kb : placement.kbPerNode) total += kb;
+        std::string line = "PID " + std::to_string(selectedPid) + " " + name + ":";
+        for (size_t node = 0; node < placement.kbPerNode.size(); ++node) {
+            char cell[48];
+            snprintf(cell, sizeof(cell), "  node%zu %s (%.0f%%)", node,
+                     formatBytes(placement.kbPerNode[node] * 1024.0).c_str(),
+                     total > 0 ? 100.0 * (double)placement.kbPerNode[node] / (double)total : 0.0);
+            line += cell;
+        }
+        char age[32];
+        snprintf(age, sizeof(age), "  [%.0fs ago]", monotonicSeconds() - placement.time);
+        line += age;
+        mvprintw(row++, 1, "%.*s", std::max(0, x - 2), line.c_str());
+    }
+    return row;
+}
+
+/**
+ * @brief Draws the memory panel: the /proc/meminfo breakdown and /proc/vmstat rates
+ * @return The first row below the panel
+ */
+int drawMemPanel(int row, const MemInfo &m) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    auto kb = [](long value) { return formatBytes(value * 1024.0); };
+    auto rate = [](unsigned long long current, unsigned long long prev) {
+        return (vmStatElapsed > 0.0 && current >= prev) ? (double)(current - prev) / vmStatElapsed : 0.0;
+    };
+    double pageSize = (double)sysconf(_SC_PAGESIZE);
+    char line[x + 1];
+
+    if (row >= y) return row;
+    snprintf(line, x, "MEM   used %s  free %s  avail %s  buffers %s  cached %s  shmem %s  dirty %s  writeback %s",
+             kb(m.memTotal - m.memAvailable).c_str(), kb(m.memFree).c_str(), kb(m.memAvailable).c_str(),
+             kb(m.buffers).c_str(), kb(m.cached).c_str(), kb(m.shmem).c_str(), kb(m.dirty).c_str(),
+             kb(m.writeback).c_str());
+    mvprintw(row++, 1, "%s", line);
+
+    if (row >= y) return row;
+    snprintf(line, x, "      anon %s  anonhuge %s  mapped %s  slab %s (reclaimable %s)  pagetables %s  committed %s/%s",
+             kb(m.anonPages).c_str(), kb(m.anonHugePages).c_str(), kb(m.mapped).c_str(), kb(m.slab).c_str(),
+             kb(m.sReclaimable).c_str(), kb(m.pageTables).c_str(), kb(m.committedAs).c_str(),
+             kb(m.commitLimit).c_str());
+    mvprintw(row++, 1, "%s", line);
+
+    if (row >= y) return row;
+    snprintf(line, x, "SWAP  used %s/%s  cached %s  in %s/s  out %s/s",
+             kb(m.swapTotal - m.swapFree).c_str(), kb(m.swapTotal).c_str(), kb(m.swapCached).c_str(),
+             formatBytes(rate(vmStat.pswpin, prevVmStat.pswpin) * pageSize).c_str(),
+             formatBytes(rate(vmStat.pswpout, prevVmStat.pswpout) * pageSize).c_str());
+    mvprintw(row++, 1, "%s", line);
+
+    if (row >= y) return row;
+    unsigned long long newOomKills = vmStat.oomKill - std::min(vmStat.oomKill, prevVmStat.oomKill);
+    snprintf(line, x, "VM    faults %.0f/s  major %.0f/s  paged in %s/s  out %s/s  scanned %.0f pages/s  oom kills %llu",
+             rate(vmStat.pgfault, prevVmStat.pgfault), rate(vmStat.pgmajfault, prevVmStat.pgmajfault),
+             formatBytes(rate(vmStat.pgpgin, prevVmStat.pgpgin) * 1024.0).c_str(),
+             formatBytes(rate(vmStat.pgpgout, prevVmStat.pgpgout) * 1024.0).c_str(),
+             rate(vmStat.pgscanKswapd, prevVmStat.pgscanKswapd) + rate(vmStat.pgscanDirect, prevVmStat.pgscanDirect),
+             vmStat.oomKill);
+    if (newOomKills > 0 && prevVmStatTime > 0.0) attron(A_BOLD);
+    mvprintw(row++, 1, "%s", line);
+    attroff(A_BOLD);
+    return row;
+}
+
+/**
+ * @brief Draws the list of processes
+ */
+void drawProcessList(const std::vector<Process> &processes) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    
+    // Max processes to show is screen height minus header lines
+    int maxRows = y - listHeaderRow - 1; 
+
+    // Scroll just enough to keep the selected process on screen
+    listedPids.clear();
+    int selected = -1;
+    for (int i = 0; i < (int)processes.size(); ++i) {
+        listedPids.push_back(processes[i].pid);
+        if (processes[i].pid == selectedPid) selected = i;
+    }
+    int first = std::max(0, selected - maxRows + 1);
+    visiblePids.assign(listedPids.begin() + std::min((int)listedPids.size(), first),
+                       listedPids.begin() + std::min((int)listedPids.size(), first + std::max(0, maxRows)));
+
+    for (int i = 0; first + i < (int)processes.size() && i < maxRows; ++i) {
+        const auto &p = processes[first + i];
+        
+        // Optional columns between MEM% and COMMAND
+        std::string extra = extraColumns(p);
+
+        // Truncate command name if too long
+        std::string name = p.name;
+        int maxNameLen = x - 33 - (int)extra.size(); // PID(6) + User(10) + CPU(6) + MEM(6) + spaces(5)
+        if ((int)name.length() > maxNameLen) {
+            name = name.substr(0, std::max(0, maxNameLen - 3)) + "...";
+        }
+
+        // Format string
+        char line[x + 1];
+        snprintf(line, x, "%-6d %-10.10s %6.1f %6.1f %s%s", 
+                 p.pid, 
+                 p.user.c_str(), 
+                 p.cpuPercent, 
+                 p.memPercent, 
+                 extra.c_str(),
+                 name.c_str());
+
+        // Clear line and print
+        mvhline(listHeaderRow + 1 + i, 0, ' ', x);
+        // A major fault spike is the earliest sign of thrashing: flag it in every column set
+        int attrs = (p.pid == selectedPid ? A_REVERSE : 0) | (p.majfltSpike ? COLOR_PAIR(4) | A_BOLD : 0);
+        attron(attrs);
+        mvprintw(listHeaderRow + 1 + i, 1, "%s", line);
+        attroff(attrs);
+    }
+}
+
+
+/**
+ * @brief Draws the cgroup hierarchy as an indented, collapsible tree
+ */
+void drawCgroupTree(const std::vector<Cgroup> &cgroups) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    int maxRows = y - listHeaderRow - 1;
+    if (maxRows < 1) return;
+
+    // Keep the cursor on screen
+    if (cgroupCursor < cgroupScroll) cgroupScroll = cgroupCursor;
+    if (cgroupCursor >= cgroupScroll + maxRows) cgroupScroll = cgroupCursor - maxRows + 1;
+
+    for (int i = 0; i < maxRows && cgroupScroll + i < (int)cgroups.size(); ++i) {
+        const auto &cg = cgroups[cgroupScroll + i];
+        std::string mem = (cg.memCurrent >= 0) ? formatBytes((double)cg.memCurrent) : "-";
+        std::string memMax = (cg.memMax >= 0) ? formatBytes((double)cg.memMax) : "-";
+        const char *marker = !cg.hasChildren ? "  " : (collapsedCgroups.count(cg.path) ? "+ " : "- ");
+
+        // Pressure is "some" avg10, the share of time at least one task stalled
+        char pressure[3][8];
+        const double values[3] = {cg.cpuPressure, cg.memPressure, cg.ioPressure};
+        for (int k = 0; k < 3; ++k) {
+            if (values[k] < 0.0) snprintf(pressure[k], sizeof(pressure[k]), "-");
+            else snprintf(pressure[k], sizeof(pressure[k]), "%.1f", values[k]);
+        }
+
+        char line[x + 1];
+        snprintf(line, x, "%6.1f %8s %8s %8s %8s %5s %5s %5s  %*s%s%s",
+                 cg.cpuPercent,
+                 mem.c_str(),
+                 memMax.c_str(),
+                 formatBytes(cg.ioReadRate).c_str(),
+                 formatBytes(cg.ioWriteRate).c_str(),
+                 pressure[0], pressure[1], pressure[2],
+                 cg.depth * 2, "",
+                 marker,
+                 cg.name.c_str());
+
+        mvhline(listHeaderRow + 1 + i, 0, ' ', x);
+        if (cgroupScroll + i == cgroupCursor) attron(A_REVERSE);
+        mvprintw(listHeaderRow + 1 + i, 1, "%s", line);
+        if (cgroupScroll + i == cgroupCursor) attroff(A_REVERSE);
+    }
+}
+
+/**
+ * @brief Draws the iotop-like view: I/O rates and delay accounting per process
+ */
+void drawIoTopList(const std::vector<Process> &processes) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    int maxRows = y - listHeaderRow - 1;
+
+    for (int i = 0; i < (int)processes.size() && i < maxRows; ++i) {
+        const auto &p = processes[i];
+        const char *ioMark = (p.ioState == IO_DENIED) ? "n/a" : "-";
+        char read[16], write[16];
+        snprintf(read, sizeof(read), "%s", ioMark);
+        snprintf(write, sizeof(write), "%s", ioMark);
+        if (p.ioState == IO_OK) {
+            snprintf(read, sizeof(read), "%s", formatBytes(p.ioReadRate).c_str());
+            snprintf(write, sizeof(write), "%s", formatBytes(p.ioWriteRate).c_str());
+        }
+        // schedstat only knows the CPU run-delay; the rest need taskstats
+        char cpuDelay[16] = "n/a", blkio[16] = "n/a", swapin[16] = "n/a", reclaim[16] = "n/a";
+        if (p.delayState != DELAY_NOT_COLLECTED) {
+            snprintf(cpuDelay, sizeof(cpuDelay), "%.1f", p.cpuDelayPercent);
+        }
+        if (p.delayState == DELAY_TASKSTATS) {
+            snprintf(blkio, sizeof(blkio), "%.1f", p.blkioDelayPercent);
+            snprintf(swapin, sizeof(swapin), "%.1f", p.swapinDelayPercent);
+            snprintf(reclaim, sizeof(reclaim), "%.1f", p.freepagesDelayPercent);
         }
+
+        char line[x + 1];
+        snprintf(line, x, "%-6d %-10.10s %8s %8s %8s %8s %8s %8s %s",
+                 p.pid, p.user.c_str(), read, write, cpuDelay, blkio, swapin, reclaim, p.name.c_str());
+        mvhline(listHeaderRow + 1 + i, 0, ' ', x);
+        mvprintw(listHeaderRow + 1 + i, 1, "%s", line);
     }
-    file.close();
-    return {memTotal, memAvailable};
 }
 
 /**
- * @brief Reads the first line of /proc/stat to get total CPU times
+ * @brief Draws aggregated process groups
  */
-SysCpuTimes getSystemCpuTimes() {
-    std::ifstream file("/proc/stat");
-    std::string line;
-    SysCpuTimes t = {0};
+void drawGroupList(const std::vector<ProcessGroup> &groups) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    int maxRows = y - listHeaderRow - 1;
 
-    std::getline(file, line);
-    if (line.rfind("cpu", 0) == 0) {
-        std::stringstream ss(line);
-        std::string cpu;
-        ss >> cpu >> t.user >> t.nice >> t.system >> t.idle >> t.iowait >> t.irq >> t.softirq >> t.steal;
-        t.total = t.user + t.nice + t.system + t.idle + t.iowait + t.irq + t.softirq + t.steal;
+    for (int i = 0; i < (int)groups.size() && i < maxRows; ++i) {
+        const auto &g = groups[i];
+        char line[x + 1];
+        const Percentiles &c = g.cpuPercentiles, &r = g.rssPercentiles;
+        auto kb = [](double value) { return formatBytes(value * 1024.0); };
+        snprintf(line, x, "%-32.32s %6d %6.1f %6.1f %6.1f %8s %8s %5.1f %5.1f %5.1f %5.1f %7s %7s %7s %7s",
+                 g.key.c_str(),
+                 g.count,
+                 g.cpuPercent,
+                 g.maxCpuPercent,
+                 g.memPercent,
+                 formatBytes(g.memRssKb * 1024.0).c_str(),
+                 formatBytes(g.maxRssKb * 1024.0).c_str(),
+                 c.p50, c.p95, c.p99, c.max,
+                 kb(r.p50).c_str(), kb(r.p95).c_str(), kb(r.p99).c_str(), kb(r.max).c_str());
+        mvhline(listHeaderRow + 1 + i, 0, ' ', x);
+        mvprintw(listHeaderRow + 1 + i, 1, "%s", line);
     }
-    file.close();
-    return t;
 }
 
 /**
- * @brief Gets all running processes by scanning /proc
- * @param totalSystemMemKb Total system memory for calculating %
- * @param totalCpuTimeDelta Total CPU time elapsed since last check
- * @return A vector of Process structs
+ * @brief Draws the per-core view: one line per core with the processes that last ran
+ *        on it and used CPU in this interval (or are running now), busiest first
  */
-std::vector<Process> getProcesses(long totalSystemMemKb, long long totalCpuTimeDelta) {
-    std::vector<Process> processes;
-    DIR *dir;
-    struct dirent *entry;
+void drawCoreView(const std::vector<Process> &processes, const std::vector<CpuBreakdown> &cores) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    int maxRows = y - listHeaderRow - 1;
 
-    if ((dir = opendir("/proc")) == NULL) {
-        return processes; // Cannot open /proc
+    // processes is sorted by the current sort key; keep that order within each core
+    std::unordered_map<int, std::string> occupants;
+    for (const auto &p : processes) {
+        if (p.stat.state != 'R' && p.cpuPercent < 0.1) continue;
+        std::string &line = occupants[p.stat.processor];
+        if ((int)line.size() > x) continue;
+        char cell[64];
+        snprintf(cell, sizeof(cell), "  %.15s/%d %.1f%s%s", p.name.c_str(), p.pid, p.cpuPercent,
+                 p.stat.state == 'R' ? "*" : "", p.migratedNow ? "!" : "");
+        line += cell;
     }
 
-    while ((entry = readdir(dir)) != NULL) {
-        // Check if directory name is a number (PID)
-        int pid = 0;
-        try {
-            pid = std::stoi(entry->d_name);
-        } catch (...) {
-            continue; // Not a PID
-        }
+    for (int i = 0; i < (int)cores.size() && i < maxRows; ++i) {
+        const CpuBreakdown &c = cores[i];
+        auto it = occupants.find(c.cpu);
+        char line[x + 1];
+        snprintf(line, x, "cpu%-2d %6.1f %s", c.cpu, c.busy, it == occupants.end() ? "  -" : it->second.c_str());
+        mvhline(listHeaderRow + 1 + i, 0, ' ', x);
+        mvprintw(listHeaderRow + 1 + i, 1, "%s", line);
+    }
+}
 
-        Process p = {0};
-        p.pid = pid;
+/**
+ * @brief Draws the top consumers view: CPU-seconds by command and by user from the
+ *        heavy hitter sketches, side by side
+ */
+void drawTopConsumers() {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    int maxRows = y - listHeaderRow - 1;
+    const int tableWidth = 64;
 
-        // 1. Read /proc/[pid]/stat for CPU times
-        std::ifstream statFile("/proc/" + std::to_string(pid) + "/stat");
-        if (!statFile.is_open()) continue;
+    std::vector<HeavyHitter> tables[2] = {
+        topHeavyHitters(lifetimeByComm, minutesByComm, showWindowedConsumers),
+        topHeavyHitters(lifetimeByUser, minutesByUser, showWindowedConsumers),
+    };
+    for (int t = 0; t < 2; ++t) {
+        int col = 1 + t * tableWidth;
+        if (col + tableWidth / 2 > x) break;
+        for (int i = 0; i < (int)tables[t].size() && i < maxRows; ++i) {
+            const HeavyHitter &h = tables[t][i];
+            char line[tableWidth + 1];
+            snprintf(line, sizeof(line), "%-20.20s %10.1f %8.1f %9s %8u", h.key, h.cpuSeconds, h.error,
+                     formatBytes(h.peakRssKb * 1024.0).c_str(), h.processes);
+            mvprintw(listHeaderRow + 1 + i, col, "%.*s", std::max(0, x - col - 1), line);
+        }
+    }
+}
 
-        std::string statLine;
-        std::getline(statFile, statLine);
-        statFile.close();
+/**
+ * @brief Draws one history graph: a title line, then the min-max range of each point as a
+ *        vertical stroke, two points per cell in braille (one in ASCII)
+ * @param scale Value at the top of the graph (0 = fit the largest value shown)
+ * @param format Formats a value for the title line
+ * @param refreshSeconds Finer buckets than this would mostly be empty
+ */
+void drawHistoryGraph(int row, int height, int width, const std::string &title, const MinMaxPyramid &pyramid,
+                      double scale, std::string (*format)(double), int color, double refreshSeconds) {
+    const int pointsPerCell = unicodeGraphs ? 2 : 1;
+    int points = std::min(width * pointsPerCell, pyramidBuckets);
+    int cells = points / pointsPerCell;
+    double span = graphSpans[graphZoom];
+    std::vector<float> mins, maxs;
+    pyramidQuery(pyramid, monotonicSeconds(), span, points, refreshSeconds, mins, maxs);
 
-        std::stringstream ss(statLine);
-        std::string value;
-        // Skip values until we get to utime and stime
-        // (1) pid (2) comm (3) state ... (14) utime (15) stime
-        for (int i = 1; i < 14; ++i) {
-            ss >> value;
-        }
-        ss >> p.utime >> p.stime;
-        // (Further values for cstime, cutime are ignored for simplicity)
+    double low = NAN, high = NAN;
+    for (int j = 0; j < points; ++j) {
+        if (std::isnan(maxs[j])) continue;
+        low = std::isnan(low) ? mins[j] : std::min(low, (double)mins[j]);
+        high = std::isnan(high) ? maxs[j] : std::max(high, (double)maxs[j]);
+    }
+    if (scale <= 0.0) scale = std::isnan(high) || high <= 0.0 ? 1.0 : high * 1.1; // Auto-scale
+    if (std::isnan(high)) {
+        mvprintw(row, 1, "%s  no data yet", title.c_str());
+    } else {
+        mvprintw(row, 1, "%s  now %s  min %s  max %s  (top %s)", title.c_str(), format(pyramid.latest).c_str(),
+                 format(low).c_str(), format(high).c_str(), format(scale).c_str());
+    }
 
-        // 2. Read /proc/[pid]/status for Name, Memory
-        std::ifstream statusFile("/proc/" + std::to_string(pid) + "/status");
-        if (!statusFile.is_open()) continue;
-        
+    // Braille dots per cell, top to bottom: left column, then right column
+    static const int dotBits[2][4] = {{0x01, 0x02, 0x04, 0x40}, {0x08, 0x10, 0x20, 0x80}};
+    int levels = height * (unicodeGraphs ? 4 : 1);
+    auto level = [&](float value) {
+        return std::max(0, std::min(levels - 1, (int)std::lround(value / scale * (levels - 1))));
+    };
+    attron(COLOR_PAIR(color));
+    for (int r = 0; r < height; ++r) {
         std::string line;
-        while (std::getline(statusFile, line)) {
-            if (line.rfind("Name:", 0) == 0) {
-                p.name = line.substr(6); // Get value after "Name: "
-                p.name.erase(p.name.find_last_not_of(" \n\r\t")+1); // Trim whitespace
-            } else if (line.rfind("VmRSS:", 0) == 0) {
-                // VmRSS is the "Resident Set Size", physical memory
-                p.memRssKb = std::stol(line.substr(7));
+        for (int c = 0; c < cells; ++c) {
+            int bits = 0;
+            for (int k = 0; k < pointsPerCell; ++k) {
+                int j = c * pointsPerCell + k;
+                if (std::isnan(maxs[j])) continue;
+                int lo = level(mins[j]), hi = level(maxs[j]);
+                if (j > 0 && !std::isnan(maxs[j - 1])) {
+                    // Join up with the previous point so a change draws as a line, not two dots
+                    lo = std::min(lo, level(maxs[j - 1]));
+                    hi = std::max(hi, level(mins[j - 1]));
+                }
+                if (!unicodeGraphs) {
+                    bits = (height - 1 - r >= lo && height - 1 - r <= hi);
+                    continue;
+                }
+                for (int d = 0; d < 4; ++d) {
+                    int dot = (height - 1 - r) * 4 + (3 - d); // Counted from the bottom
+                    if (dot >= lo && dot <= hi) bits |= dotBits[k][d];
+                }
+            }
+            if (bits == 0) {
+                line += ' ';
+            } else if (!unicodeGraphs) {
+                line += '|';
+            } else {
+                int codepoint = 0x2800 + bits; // UTF-8, three bytes
+                line += (char)(0xE0 | (codepoint >> 12));
+                line += (char)(0x80 | ((codepoint >> 6) & 0x3F));
+                line += (char)(0x80 | (codepoint & 0x3F));
             }
         }
-        statusFile.close();
-        if (p.name.empty()) continue; // Process might have terminated
-
-        // 3. Get Username
-        p.user = getUsername(pid);
+        mvaddstr(row + 1 + r, 1, line.c_str());
+    }
+    attroff(COLOR_PAIR(color));
+}
 
-        // 4. Calculate CPU %
-        long long currentProcessTotalTime = p.utime + p.stime;
-        long long prevProcessTotalTime = 0;
-        if (prevProcessTimes.count(pid)) {
-            prevProcessTotalTime = prevProcessTimes[pid].first + prevProcessTimes[pid].second;
-        }
+/**
+ * @brief Draws the graph view: system CPU and memory, and the selected process's CPU%
+ *        and RSS, over the current zoom span
+ */
+void drawGraphView(double refreshSeconds) {
+    int y, x;
+    getmaxyx(stdscr, y, x);
+    int top = listHeaderRow + 1;
+    int available = y - top;
+    int width = x - 2;
+    bool selection = selectedPid >= 0;
+    int graphs = selection ? 4 : 2;
+    int height = available / graphs - 1; // Each graph also has a title line
+    if (height < 1 || width < 10) return;
 
-        long long processTimeDelta = currentProcessTotalTime - prevProcessTotalTime;
-        if (totalCpuTimeDelta > 0) {
-            p.cpuPercent = 100.0 * (double)processTimeDelta / (double)totalCpuTimeDelta;
-        } else {
-            p.cpuPercent = 0.0;
+    auto percent = [](double value) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%.1f%%", value);
+        return std::string(buf);
+    };
+    auto kilobytes = [](double value) { return formatBytes(value * 1024.0); };
+    drawHistoryGraph(top, height, width, "CPU busy", cpuGraph, 100.0, percent, 2, refreshSeconds);
+    drawHistoryGraph(top + height + 1, height, width, "Memory used", memGraph, 100.0, percent, 7, refreshSeconds);
+    if (!selection) {
+        if (top + 2 * (height + 1) < y) {
+            mvprintw(top + 2 * (height + 1), 1, "Select a process (Up/Down in the process list) to graph it too");
         }
-        
-        // 5. Calculate Memory %
-        if (totalSystemMemKb > 0) {
-            p.memPercent = 100.0 * (double)p.memRssKb / (double)totalSystemMemKb;
-        } else {
-            p.memPercent = 0.0;
+        return;
+    }
+    std::string name = std::to_string(selectedPid);
+    for (const auto &snapshot : history) {
+        for (const auto &p : snapshot.processes) {
+            if (p.pid == selectedPid) name = std::to_string(p.pid) + " " + p.name;
         }
-
-        processes.push_back(p);
     }
-    closedir(dir);
-    return processes;
+    drawHistoryGraph(top + 2 * (height + 1), height, width, name + " CPU", selectedCpuGraph, 0.0, percent, 6, refreshSeconds);
+    drawHistoryGraph(top + 3 * (height + 1), height, width, name + " RSS", selectedRssGraph, 0.0, kilobytes, 5, refreshSeconds);
 }
 
-// --- Process Killing ---
-
 /**
- * @brief Draws a new window to ask for a PID to kill
+ * @brief Draws the exited processes view: exit totals per command on the left, the
+ *        most recent exits (newest first) on the right. '*' marks processes no
+ *        refresh ever saw.
  */
-void killProcessWindow() {
+void drawExitedProcesses() {
     int y, x;
-    getmaxyx(stdscr, y, x); // Get screen dimensions
-    // Create a small window in the center
-    WINDOW *killWin = newwin(5, 40, y / 2 - 2, x / 2 - 20);
-    box(killWin, 0, 0);
-    wrefresh(killWin);
-
-    mvwprintw(killWin, 1, 2, "Enter PID to kill (or Esc to_cancel):");
-    wattron(killWin, A_REVERSE);
-    mvwprintw(killWin, 2, 2, "                         "); // Input area
-    wattroff(killWin, A_REVERSE);
-
-    echo(); // Turn echo on to see typing
-    keypad(killWin, TRUE); // Enable arrow keys, Esc
-    
-    char pidStr[20];
-    int ch;
-    
-    wmove(killWin, 2, 2); // Move cursor to input area
-    wrefresh(killWin);
+    getmaxyx(stdscr, y, x);
+    int maxRows = y - listHeaderRow - 1;
+    double now = monotonicSeconds();
 
-    // Get string input, but handle Esc
-    int i = 0;
-    while(true) {
-        ch = wgetch(killWin);
-        if (ch == 27) { // 27 is the Esc key
-            i = -1; // Signal for cancel
-            break;
-        }
-        if (ch == '\n') { // Enter key
-            pidStr[i] = '\0';
-            break;
-        }
-        if (ch == KEY_BACKSPACE || ch == 127) {
-            if (i > 0) {
-                i--;
-                mvwprintw(killWin, 2, 2 + i, " "); // Erase char on screen
-                wmove(killWin, 2, 2 + i);
-            }
-        } else if (isdigit(ch) && i < 19) {
-            pidStr[i] = (char)ch;
-            waddch(killWin, ch);
-            i++;
-        }
+    std::vector<HeavyHitter> totals = exitedByComm.counters;
+    std::sort(totals.begin(), totals.end(), [](const HeavyHitter &a, const HeavyHitter &b) {
+        return a.processes != b.processes ? a.processes > b.processes : a.cpuSeconds > b.cpuSeconds;
+    });
+    for (int i = 0; i < (int)totals.size() && i < maxRows; ++i) {
+        const HeavyHitter &h = totals[i];
+        mvprintw(listHeaderRow + 1 + i, 1, "%-16.16s %7u %9.1f %9s", h.key, h.processes, h.cpuSeconds,
+                 formatBytes(h.peakRssKb * 1024.0).c_str());
     }
-    
-    noecho(); // Turn echo back off
-    delwin(killWin); // Delete the window
-
-    if (i == -1) return; // User cancelled
 
-    try {
-        int pid = std::stoi(pidStr);
-        // Send SIGTERM (15) - a request to terminate
-        if (kill(pid, SIGTERM) == 0) {
-            // Success
+    if (x <= 48 + 40) return;
+    size_t shown = std::min<unsigned long long>(exitCount, exitRingSize);
+    for (size_t i = 0; i < shown && (int)i < maxRows; ++i) {
+        const ExitedProcess &e = exitRing[(exitRingNext + exitRingSize - 1 - i) % exitRingSize];
+        char exitText[12];
+        if (e.exitCode < 0) {
+            snprintf(exitText, sizeof(exitText), "?");
+        } else if (e.exitCode & 0x7f) {
+            snprintf(exitText, sizeof(exitText), "sig%d", e.exitCode & 0x7f);
         } else {
-            // Failed (e.g., no permissions)
+            snprintf(exitText, sizeof(exitText), "%d", (e.exitCode >> 8) & 0xff);
         }
-    } catch (...) {
-        // Invalid PID
+        char lifetime[24];
+        if (e.lifetime < 60.0) {
+            snprintf(lifetime, sizeof(lifetime), "%.3fs", e.lifetime); // Most exits here are short-lived
+        } else {
+            snprintf(lifetime, sizeof(lifetime), "%s", formatDuration(e.lifetime).c_str());
+        }
+        char line[160];
+        snprintf(line, sizeof(line), "%7d %7d %-10.10s %8.2f %9s %9s %6s %6s %s%s", e.pid, e.ppid, e.user,
+                 e.cpuSeconds, formatBytes(e.peakRssKb * 1024.0).c_str(), lifetime,
+                 exitText, formatDuration(now - e.exitTime).c_str(), e.name, e.scanned ? "" : " *");
+        mvprintw(listHeaderRow + 1 + (int)i, 48, "%.*s", x - 49, line);
     }
 }
 
-
-// --- Sorting Comparators ---
-bool compareByCpu(const Process &a, const Process &b) {
-    return a.cpuPercent > b.cpuPercent;
-}
-bool compareByMem(const Process &a, const Process &b) {
-    return a.memPercent > b.memPercent;
-}
-bool compareByPid(const Process &a, const Process &b) {
-    return a.pid < b.pid;
+/**
+ * @brief Draws one heatmap cell per CPU, scaled to the row's busiest CPU.
+ *        Cells on CPUs taking more than twice their fair share are red when highlight is set.
+ */
+void drawIrqHeatRow(int row, int col, int width, const double *rates, double mean, bool highlight) {
+    static const char levels[] = " .:-=+*#%@";
+    double rowMax = 0.0;
+    for (size_t c = 0; c < irqCpuCount; ++c) rowMax = std::max(rowMax, rates[c]);
+    for (int c = 0; c < width && c < (int)irqCpuCount; ++c) {
+        int level = (rates[c] <= 0.0 || rowMax <= 0.0) ? 0 : 1 + (int)(rates[c] / rowMax * 8.999);
+        int pair = (highlight && rates[c] > 2.0 * mean) ? 4 : (level >= 7 ? 6 : 2);
+        attron(COLOR_PAIR(pair));
+        mvaddch(row, col + c, levels[level]);
+        attroff(COLOR_PAIR(pair));
+    }
+    if ((int)irqCpuCount > width) mvaddch(row, col + width, '+');
 }
 
-
-// --- Drawing Functions ---
-
 /**
- * @brief Draws the main UI headers
+ * @brief Draws the interrupt view: per-CPU IRQ and softirq rates as a heatmap, busiest sources first.
+ *        The ALL row sums every source per CPU, which is where a hot core shows up.
  */
-void drawHeader() {
-    // Get screen size
+void drawInterruptView() {
     int y, x;
     getmaxyx(stdscr, y, x);
+    int maxRows = y - listHeaderRow - 1;
+    if (maxRows < 1 || irqCpuCount == 0) return;
+    const int heatCol = 45;
+    int heatWidth = std::max(0, std::min((int)irqCpuCount, x - heatCol - 2));
 
-    // Enable color
-    attron(COLOR_PAIR(1));
-    // Draw top bar
-    mvhline(0, 0, ' ', x);
-    mvprintw(0, 1, "SysMon (Press 'q' to quit, 'c'/'m'/'p' to sort, 'k' to kill)");
-    
-    // Draw process list header
-    mvhline(4, 0, ' ', x);
-    mvprintw(4, 1, "%-6s %-10s %-6s %-6s %s", "PID", "USER", "CPU%", "MEM%", "COMMAND");
-    attroff(COLOR_PAIR(1));
+    static std::vector<size_t> order;
+    order.clear();
+    for (size_t r = 0; r < irqSources.size(); ++r) order.push_back(r);
+    std::sort(order.begin(), order.end(), [](size_t a, size_t b) {
+        return irqSources[a].totalRate > irqSources[b].totalRate;
+    });
+
+    // Imbalance: busiest CPU over the mean CPU, 1.0 when perfectly spread
+    double total = 0.0, busiest = 0.0;
+    int busiestCpu = 0;
+    for (size_t c = 0; c < irqCpuCount; ++c) {
+        total += irqCpuTotals[c];
+        if (irqCpuTotals[c] > busiest) {
+            busiest = irqCpuTotals[c];
+            busiestCpu = (int)c;
+        }
+    }
+    double mean = total / (double)irqCpuCount;
+    int row = listHeaderRow + 1;
+    mvprintw(row, 1, "%-10s %9.0f %9.0f %5d %4.1f", "ALL", total, busiest, busiestCpu,
+             mean > 0.0 ? busiest / mean : 0.0);
+    drawIrqHeatRow(row, heatCol, heatWidth, irqCpuTotals.data(), mean, irqCpuCount > 1);
+    row++;
+
+    for (size_t i = 0; i < order.size() && row < listHeaderRow + 1 + maxRows; ++i) {
+        const IrqSource &src = irqSources[order[i]];
+        const double *rates = &irqRates[order[i] * irqCpuCount];
+        double srcMean = src.totalRate / (double)irqCpuCount;
+        double imbalance = srcMean > 0.0 ? src.maxRate / srcMean : 0.0;
+        char cpu[12] = "-";
+        if (src.maxCpu >= 0) snprintf(cpu, sizeof(cpu), "%d", src.maxCpu);
+        mvprintw(row, 1, "%-10.10s %9.0f %9.0f %5s %4.1f", src.name, src.totalRate, src.maxRate, cpu, imbalance);
+        // Hardware IRQs are often pinned to one CPU on purpose; softirqs piling up on one is the problem
+        drawIrqHeatRow(row, heatCol, heatWidth, rates, srcMean, src.softirq && irqCpuCount > 1);
+        if (heatCol + heatWidth + 2 < x) {
+            mvprintw(row, heatCol + heatWidth + 2, "%.*s", x - heatCol - heatWidth - 3,
+                     src.softirq ? "softirq" : src.desc);
+        }
+        row++;
+    }
 }
 
+// --- Batch Mode ---
+
 /**
- * @brief Draws the system summary (CPU, Mem)
+ * @brief Prints one tab-separated snapshot: processes (and groups, if asked for) with
+ *        their CPU% and RSS percentiles over the histogram window
  */
-void drawSystemInfo(double cpuUsage, long memUsed, long memTotal) {
-    // 1. CPU
-    int barWidth = 20;
-    int cpuBlocks = (int)std::round(cpuUsage / 100.0 * barWidth);
-    std::string cpuBar = "";
-    for(int i = 0; i < barWidth; ++i) {
-        cpuBar += (i < cpuBlocks) ? "|" : " ";
+void printBatchSnapshot(const std::vector<Process> &processes, const std::vector<ProcessGroup> &groups,
+                        bool grouped) {
+    printf("# time=%lld processes=%zu window=%.0fs\n", (long long)time(NULL), processes.size(),
+           histogramWindowSeconds);
+    printf("PID\tUSER\tCPU%%\tRSS_KB\tCPU_P50\tCPU_P95\tCPU_P99\tCPU_MAX\t"
+           "RSS_P50_KB\tRSS_P95_KB\tRSS_P99_KB\tRSS_MAX_KB\tCOMMAND\n");
+    for (const auto &p : processes) {
+        const Percentiles &c = p.cpuPercentiles, &r = p.rssPercentiles;
+        printf("%d\t%s\t%.1f\t%ld\t%.1f\t%.1f\t%.1f\t%.1f\t%.0f\t%.0f\t%.0f\t%.0f\t%s\n", p.pid, p.user.c_str(),
+               p.cpuPercent, p.memRssKb, c.p50, c.p95, c.p99, c.max, r.p50, r.p95, r.p99, r.max, p.name.c_str());
     }
-    mvprintw(2, 1, "CPU [%s] %5.1f%%", cpuBar.c_str(), cpuUsage);
-
-    // 2. Memory
-    double memPercent = 100.0 * (double)memUsed / (double)memTotal;
-    int memBlocks = (int)std::round(memPercent / 100.0 * barWidth);
-    std::string memBar = "";
-    for(int i = 0; i < barWidth; ++i) {
-        memBar += (i < memBlocks) ? "|" : " ";
+    if (grouped) {
+        printf("%s\tPROCS\tCPU%%\tRSS_KB\tCPU_P50\tCPU_P95\tCPU_P99\tCPU_MAX\t"
+               "RSS_P50_KB\tRSS_P95_KB\tRSS_P99_KB\tRSS_MAX_KB\n", groupByName(currentGroupBy));
+        for (const auto &g : groups) {
+            const Percentiles &c = g.cpuPercentiles, &r = g.rssPercentiles;
+            printf("%s\t%d\t%.1f\t%ld\t%.1f\t%.1f\t%.1f\t%.1f\t%.0f\t%.0f\t%.0f\t%.0f\n", g.key.c_str(), g.count,
+                   g.cpuPercent, g.memRssKb, c.p50, c.p95, c.p99, c.max, r.p50, r.p95, r.p99, r.max);
+        }
     }
-    mvprintw(3, 1, "Mem [%s] %5.1f%% (%ld/%ld KB)", memBar.c_str(), memPercent, memUsed, memTotal);
+    printf("\n");
+    fflush(stdout);
 }
 
 /**
- * @brief Draws the list of processes
+ * @brief Headless mode: samples like the interactive loop, without a terminal
+ * @param iterations Snapshots to print, or 0 to run until killed
  */
-void drawProcessList(const std::vector<Process> &processes) {
-    int y, x;
-    getmaxyx(stdscr, y, x);
-    
-    // Max processes to show is screen height minus header lines
-    int maxRows = y - 5; 
-
-    for (int i = 0; i < processes.size() && i < maxRows; ++i) {
-        const auto &p = processes[i];
-        
-        // Truncate command name if too long
-        std::string name = p.name;
-        int maxNameLen = x - 33; // PID(6) + User(10) + CPU(6) + MEM(6) + spaces(5)
-        if (name.length() > maxNameLen) {
-            name = name.substr(0, maxNameLen - 3) + "...";
+int runBatch(int intervalMs, int iterations, bool grouped) {
+    loadUsernames();
+    prevProcStat = getProcStat();
+    prevProcessScanCpuTotal = prevProcStat.cpu.total;
+    getProcesses(1, 1, 1); // Prime the per-process deltas
+    for (int i = 0; iterations == 0 || i < iterations; ++i) {
+        usleep(intervalMs * 1000);
+        MemInfo memInfo = getMemoryInfo();
+        ProcStat currentProcStat = getProcStat();
+        std::vector<Process> processes = getProcesses(memInfo.memTotal, memInfo.memAvailable,
+                                                      currentProcStat.cpu.total - prevProcessScanCpuTotal);
+        prevProcessScanCpuTotal = currentProcStat.cpu.total;
+        prevProcStat = currentProcStat;
+        sortProcesses(processes);
+        std::vector<ProcessGroup> groups;
+        if (grouped) {
+            groups = groupProcesses(processes, currentGroupBy);
+            recordGroupHistory(groups, currentGroupBy, monotonicSeconds());
         }
-
-        // Format string
-        char line[x + 1];
-        snprintf(line, x, "%-6d %-10.10s %6.1f %6.1f %s", 
-                 p.pid, 
-                 p.user.c_str(), 
-                 p.cpuPercent, 
-                 p.memPercent, 
-                 name.c_str());
-
-        // Clear line and print
-        mvhline(5 + i, 0, ' ', x);
-        mvprintw(5 + i, 1, "%s", line);
+        printBatchSnapshot(processes, groups, grouped);
     }
+    stopBackgroundReader();
+    return 0;
 }
 
+void printUsage(const char *program) {
+    fprintf(stderr,
+            "usage: %s [-b [-d seconds] [-n count] [-g service|user|command|ppid|session]] [-w minutes]\n"
+            "  -b  batch mode: print tab-separated snapshots instead of the interactive display\n"
+            "  -d  seconds between snapshots (default 2)\n"
+            "  -n  number of snapshots (default: until killed)\n"
+            "  -g  also print per-group totals\n"
+            "  -w  percentile window in minutes (default 10)\n",
+            program);
+}
 
 // --- Main Function ---
 
-int main() {
-    // 1. Initialize ncurses
+int main(int argc, char *argv[]) {
+    // 0. Command line
+    int batchIntervalMs = 2000, batchIterations = 0;
+    bool batchGrouped = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (arg == "-b") {
+            batchMode = true;
+        } else if (arg == "-d" && value && atof(value) > 0) {
+            batchIntervalMs = (int)(atof(value) * 1000);
+            ++i;
+        } else if (arg == "-n" && value && atoi(value) > 0) {
+            batchIterations = atoi(value);
+            ++i;
+        } else if (arg == "-w" && value && atof(value) > 0) {
+            histogramWindowSeconds = atof(value) * 60.0;
+            ++i;
+        } else if (arg == "-g" && value) {
+            static const GroupBy groupings[] = {GROUP_BY_SERVICE, GROUP_BY_USER, GROUP_BY_COMM, GROUP_BY_PPID,
+                                                GROUP_BY_SESSION};
+            batchGrouped = false;
+            for (GroupBy g : groupings) {
+                if (strcasecmp(value, groupByName(g)) == 0) {
+                    currentGroupBy = g;
+                    batchGrouped = true;
+                }
+            }
+            if (!batchGrouped) {
+                printUsage(argv[0]);
+                return 2;
+            }
+            currentView = VIEW_GROUPS; // Resolves service attribution when grouping by service
+            ++i;
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (batchMode) {
+        return runBatch(batchIntervalMs, batchIterations, batchGrouped);
+    }
+
+    // 1. Initialize ncurses (in the user's locale, for braille graphs; numbers stay "C")
+    setlocale(LC_ALL, "");
+    setlocale(LC_NUMERIC, "C");
+    unicodeGraphs = strcmp(nl_langinfo(CODESET), "UTF-8") == 0;
     initscr();              // Start ncurses mode
     cbreak();               // Disable line buffering
     noecho();               // Don't echo user input
     keypad(stdscr, TRUE);   // Enable F-keys, arrows
-    timeout(2000);          // Set refresh rate (2000ms = 2s)
+    timeout(0);             // Non-blocking getch(); waitForEvent() does the waiting
     curs_set(0);            // Hide cursor
 
     // Initialize colors
@@ -415,24 +4995,35 @@ int main() {
         start_color();
         // Pair 1: White text on Blue background (for headers)
         init_pair(1, COLOR_WHITE, COLOR_BLUE);
+        // Pairs 2-8: CPU bar segments (user, nice, system, irq, iowait, steal, guest)
+        init_pair(2, COLOR_GREEN, COLOR_BLACK);
+        init_pair(3, COLOR_BLUE, COLOR_BLACK);
+        init_pair(4, COLOR_RED, COLOR_BLACK);
+        init_pair(5, COLOR_MAGENTA, COLOR_BLACK);
+        init_pair(6, COLOR_YELLOW, COLOR_BLACK);
+        init_pair(7, COLOR_CYAN, COLOR_BLACK);
+        init_pair(8, COLOR_WHITE, COLOR_BLACK);
     }
 
     // 2. Initial Data Load
     loadUsernames(); // Load UID->Username map once
-    prevSysCpuTimes = getSystemCpuTimes(); // Get first CPU snapshot
+    prevProcStat = getProcStat(); // Get first CPU snapshot
+    
+    prevProcessScanCpuTotal = prevProcStat.cpu.total;
     
     // Get first snapshot of process times
-    auto tempProcs = getProcesses(1, 1); // Dummy values first
-    for(const auto& p : tempProcs) {
-        prevProcessTimes[p.pid] = {p.utime, p.stime};
-    }
+    getProcesses(1, 1, 1); // Dummy values first
     usleep(100000); // Wait 0.1 sec for a small delta
     
+    std::vector<Cgroup> cgroups; // Last cgroup walk, for cursor movement
+    const int refreshIntervalMs = 2000; // Refresh rate (2000ms = 2s)
+    registerPsiTriggers(); // Stall spikes wake the loop before the next refresh
+    openExitEvents();      // Catches processes too short-lived for any refresh
 
     // 3. Main Loop
     while (true) {
         // --- A. Handle Input ---
-        int ch = getch(); // Get user input (non-blocking)
+        int ch = waitForEvent(refreshIntervalMs); // Key press, stall event or refresh
         if (ch == 'q') {
             break; // Quit
         }
@@ -440,55 +5031,249 @@ int main() {
             case 'c': currentSortMode = BY_CPU; break;
             case 'm': currentSortMode = BY_MEM; break;
             case 'p': currentSortMode = BY_PID; break;
+            case '>': currentSortMode = (SortMode)((currentSortMode + 1) % SORT_MODE_COUNT); break;
+            case '<': currentSortMode = (SortMode)((currentSortMode + SORT_MODE_COUNT - 1) % SORT_MODE_COUNT); break;
+            case 'f': currentColumnSet = (ColumnSet)((currentColumnSet + 1) % COLUMN_SET_COUNT); break;
             case 'k': 
                 killProcessWindow();
                 // Redraw immediately after kill window closes
                 clear(); 
                 break;
+            case 'g':
+                currentView = (currentView == VIEW_CGROUPS) ? VIEW_PROCESSES : VIEW_CGROUPS;
+                break;
+            case 'G':
+                currentView = (currentView == VIEW_GROUPS) ? VIEW_PROCESSES : VIEW_GROUPS;
+                break;
+            case 'b':
+                currentGroupBy = (GroupBy)((currentGroupBy + 1) % (GROUP_BY_SESSION + 1));
+                break;
+            case 'N': showNumaPanel = !showNumaPanel; break;
+            case 'C':
+                currentView = (currentView == VIEW_CORES) ? VIEW_PROCESSES : VIEW_CORES;
+                break;
+            case 'T':
+                currentView = (currentView == VIEW_TOP_CONSUMERS) ? VIEW_PROCESSES : VIEW_TOP_CONSUMERS;
+                break;
+            case 'w': showWindowedConsumers = !showWindowedConsumers; break;
+            case 'x':
+                currentView = (currentView == VIEW_EXITED) ? VIEW_PROCESSES : VIEW_EXITED;
+                break;
+            case 'I':
+                currentView = (currentView == VIEW_INTERRUPTS) ? VIEW_PROCESSES : VIEW_INTERRUPTS;
+                break;
+            case 'o':
+                if (currentView == VIEW_IOTOP) {
+                    currentView = VIEW_PROCESSES;
+                } else {
+                    currentView = VIEW_IOTOP;
+                    // Like iotop, start sorted by I/O wait when delays are available
+                    if (currentSortMode < BY_IO_READ) {
+                        currentSortMode = initTaskstats() ? BY_IO_DELAY : BY_IO_READ;
+                    }
+                }
+                break;
+            case 'd': showDiskPanel = !showDiskPanel; break;
+            case 'D': showAllDisks = !showAllDisks; break;
+            case 'n': showNetPanel = !showNetPanel; break;
+            case 'V': hideVirtualNet = !hideVirtualNet; break;
+            case '1': showPerCoreCpu = !showPerCoreCpu; break;
+            case 'M': showMemPanel = !showMemPanel; break;
+            case 's': showPsiPanel = !showPsiPanel; break;
+            case 'S': showServiceColumn = !showServiceColumn; break;
+            case KEY_UP:
+            case KEY_DOWN:
+                if (currentView == VIEW_CGROUPS) {
+                    if (ch == KEY_UP && cgroupCursor > 0) cgroupCursor--;
+                    if (ch == KEY_DOWN && cgroupCursor + 1 < (int)cgroups.size()) cgroupCursor++;
+                } else if (currentView == VIEW_PROCESSES && !listedPids.empty()) {
+                    // Move by PID, so the selection survives re-sorting; start at the top
+                    auto it = std::find(listedPids.begin(), listedPids.end(), selectedPid);
+                    int index = (it == listedPids.end()) ? -1 : (int)(it - listedPids.begin());
+                    if (index < 0) index = 0;
+                    else if (ch == KEY_UP) index = std::max(0, index - 1);
+                    else index = std::min((int)listedPids.size() - 1, index + 1);
+                    selectedPid = listedPids[index];
+                }
+                break;
+            case 27: // Esc
+                selectedPid = -1;
+                break;
+            case ' ': toggleHistoryPause(); break;
+            case 'h':
+                currentView = (currentView == VIEW_GRAPHS) ? VIEW_PROCESSES : VIEW_GRAPHS;
+                break;
+            case '+': graphZoom = std::max(0, graphZoom - 1); break;
+            case '-': graphZoom = std::min(graphSpanCount - 1, graphZoom + 1); break;
+            case KEY_LEFT: stepHistory(-1); break;
+            case KEY_RIGHT: stepHistory(1); break;
+            case '/':
+                editFilterWindow();
+                clear();
+                break;
+            case '\n':
+            case KEY_ENTER:
+                if (currentView == VIEW_CGROUPS && cgroupCursor < (int)cgroups.size()) {
+                    const std::string &path = cgroups[cgroupCursor].path;
+                    if (collapsedCgroups.count(path)) {
+                        collapsedCgroups.erase(path);
+                    } else if (cgroups[cgroupCursor].hasChildren) {
+                        collapsedCgroups.insert(path);
+                    }
+                }
+                break;
         }
 
         // --- B. Gather Data ---
         // 1. System Memory
-        auto memInfo = getMemoryInfo();
-        long memTotal = memInfo.first;
-        long memAvailable = memInfo.second;
+        MemInfo memInfo = getMemoryInfo();
+        long memTotal = memInfo.memTotal;
+        long memAvailable = memInfo.memAvailable;
         long memUsed = memTotal - memAvailable;
 
         // 2. System CPU
-        SysCpuTimes currentSysCpuTimes = getSystemCpuTimes();
-        long long totalDelta = currentSysCpuTimes.total - prevSysCpuTimes.total;
-        long long idleDelta = currentSysCpuTimes.idle - prevSysCpuTimes.idle;
-        double sysCpuUsage = (totalDelta > 0) ? 100.0 * (double)(totalDelta - idleDelta) / (double)totalDelta : 0.0;
+        ProcStat currentProcStat = getProcStat();
+        CpuBreakdown cpuUsage = getCpuBreakdown(currentProcStat.cpu, prevProcStat.cpu);
+        SchedActivity schedActivity = getSchedActivity(currentProcStat, prevProcStat);
+        std::vector<CpuBreakdown> coreUsage;
+        if (showPerCoreCpu || currentView == VIEW_CORES) {
+            for (size_t i = 0; i < currentProcStat.cores.size(); ++i) {
+                // Match by core number: offline cores are missing from /proc/stat
+                const SysCpuTimes &core = currentProcStat.cores[i];
+                const SysCpuTimes *prev = &core;
+                if (i < prevProcStat.cores.size() && prevProcStat.cores[i].cpu == core.cpu) {
+                    prev = &prevProcStat.cores[i];
+                } else {
+                    for (const auto &candidate : prevProcStat.cores) {
+                        if (candidate.cpu == core.cpu) prev = &candidate;
+                    }
+                }
+                coreUsage.push_back(getCpuBreakdown(core, *prev));
+            }
+        }
         
-        // 3. Processes
-        std::vector<Process> processes = getProcesses(memTotal, totalDelta);
+        // History graphs keep sampling whatever the view (and while paused)
+        double sampleTime = monotonicSeconds();
+        pyramidAdd(cpuGraph, sampleTime, cpuUsage.busy);
+        pyramidAdd(memGraph, sampleTime, memTotal > 0 ? 100.0 * memUsed / memTotal : 0.0);
+
+        // 3. Summary panels
+        if (showDiskPanel) {
+            getDiskStats();
+        }
+        if (showNetPanel) {
+            getNetStats();
+        }
+        if (showPsiPanel) {
+            getPressure();
+        }
+        if (showMemPanel) {
+            updateVmStat();
+        }
+
+        // 4. Processes, cgroups or interrupts (only the process views scan /proc/[pid]).
+        // The scan is moved into the history and shown from there, live or paused.
+        std::vector<Process> noProcesses;
+        std::vector<Process> *shownProcesses = &noProcesses;
+        if (currentView == VIEW_CGROUPS) {
+            cgroups = getCgroups();
+            if (cgroupCursor >= (int)cgroups.size()) cgroupCursor = std::max(0, (int)cgroups.size() - 1);
+        } else if (currentView == VIEW_INTERRUPTS) {
+            getIrqStats();
+        } else {
+            std::vector<Process> scan = getProcesses(memTotal, memAvailable,
+                                                     currentProcStat.cpu.total - prevProcessScanCpuTotal);
+            prevProcessScanCpuTotal = currentProcStat.cpu.total;
+            updateSelectionGraphs(scan, monotonicSeconds());
+            recordSnapshot({0, time(NULL), monotonicSeconds(), cpuUsage, coreUsage, schedActivity, memUsed, memTotal,
+                            std::move(scan)});
+            shownProcesses = &history.back().processes;
+        }
+
+        // While paused, collection above goes on but the kept snapshot is shown
+        if (Snapshot *shown = shownSnapshot()) {
+            cpuUsage = shown->cpuUsage;
+            coreUsage = shown->coreUsage;
+            schedActivity = shown->schedActivity;
+            memUsed = shown->memUsed;
+            memTotal = shown->memTotal;
+            shownProcesses = &shown->processes;
+        }
+        // Sorting reorders the snapshot in place; only a filter makes a (smaller) copy
+        std::vector<Process> filtered;
+        if (!processFilter.empty()) {
+            filtered = filterProcesses(*shownProcesses);
+            shownProcesses = &filtered;
+        }
+        std::vector<Process> &processes = *shownProcesses;
+
+        // 5. NUMA placement of the selected process, read in the background
+        if (showNumaPanel) {
+            getNumaStats();
+            requestNumaPlacement(selectedPid, 10.0);
+        }
+
+        // 6. PSS/USS read so far (requested below, after drawing, for the rows on screen)
+        bool showSmaps = currentColumnSet == COLS_MEMORY && currentView == VIEW_PROCESSES;
+        if (showSmaps) {
+            attachSmapsRollups(processes);
+        }
 
         // --- C. Process Data ---
         // 1. Sort
-        if (currentSortMode == BY_CPU) {
-            std::sort(processes.begin(), processes.end(), compareByCpu);
-        } else if (currentSortMode == BY_MEM) {
-            std::sort(processes.begin(), processes.end(), compareByMem);
-        } else if (currentSortMode == BY_PID) {
-            std::sort(processes.begin(), processes.end(), compareByPid);
-        }
+        sortProcesses(processes);
 
-        // 2. Update previous times for next loop
-        prevSysCpuTimes = currentSysCpuTimes;
-        prevProcessTimes.clear();
-        for (const auto &p : processes) {
-            prevProcessTimes[p.pid] = {p.utime, p.stime};
+        // 2. Aggregate
+        std::vector<ProcessGroup> groups;
+        if (currentView == VIEW_GROUPS) {
+            groups = groupProcesses(processes, currentGroupBy);
+            if (!historyPaused && processFilter.empty()) {
+                recordGroupHistory(groups, currentGroupBy, monotonicSeconds());
+            } else {
+                attachGroupPercentiles(groups);
+            }
         }
+
+        // 3. Update previous times for next loop
+        prevProcStat = currentProcStat;
         
         // --- D. Draw UI ---
         clear(); // Clear screen
+        int row = drawSystemInfo(cpuUsage, coreUsage, schedActivity, memUsed, memTotal);
+        if (showMemPanel) row = drawMemPanel(row, memInfo);
+        if (showDiskPanel) row = drawDiskPanel(row);
+        if (showNetPanel) row = drawNetPanel(row);
+        if (showPsiPanel) row = drawPsiPanel(row);
+        if (showNumaPanel) row = drawNumaPanel(row, processes);
+        listHeaderRow = row;
         drawHeader();
-        drawSystemInfo(sysCpuUsage, memUsed, memTotal);
-        drawProcessList(processes);
+        if (currentView == VIEW_CGROUPS) {
+            drawCgroupTree(cgroups);
+        } else if (currentView == VIEW_GROUPS) {
+            drawGroupList(groups);
+        } else if (currentView == VIEW_INTERRUPTS) {
+            drawInterruptView();
+        } else if (currentView == VIEW_CORES) {
+            drawCoreView(processes, coreUsage);
+        } else if (currentView == VIEW_TOP_CONSUMERS) {
+            drawTopConsumers();
+        } else if (currentView == VIEW_EXITED) {
+            drawExitedProcesses();
+        } else if (currentView == VIEW_GRAPHS) {
+            drawGraphView(refreshIntervalMs / 1000.0);
+        } else if (currentView == VIEW_IOTOP) {
+            drawIoTopList(processes);
+        } else {
+            drawProcessList(processes);
+        }
         refresh(); // Show all changes
+        if (showSmaps) {
+            requestSmapsRollups(visiblePids, smapsMaxAgeSeconds);
+        }
     }
 
     // 4. Cleanup
+    stopBackgroundReader();
     endwin(); // Exit ncurses mode
     return 0;
 }
\ No newline at end of file